@@ -37,6 +37,9 @@
 #define MEANINGFUL_RESET
 #define DIAGROM_HACK
 
+// cycle-budget instrumentation of the emulation loop, readable in config mode (see emuProfile.h)
+//#define EMU_PROFILING
+
 #include <malloc.h>
 #include <ctype.h>
 #include <string.h>
@@ -127,6 +130,7 @@ extern void writeReSID( uint8_t A, uint8_t D );
 extern void writeReSID2( uint8_t A, uint8_t D );
 extern void outputReSID( int16_t *left, int16_t *right );
 extern void readRegs( uint8_t *p1, uint8_t *p2 );
+extern void predictVoice3( uint8_t sid, uint8_t *osc3, uint8_t *env3, int n, int step );
 
 #define D0			0
 #define A0			16
@@ -181,8 +185,25 @@ extern void readRegs( uint8_t *p1, uint8_t *p2 );
 #define SID_ADDRESS( g )	(  ( (g) >> A0 ) & 0x1f )
 #define SID_RESET( g )	    ( !( (g) & bRESET ) )
 
-#define WAIT_FOR_VIC_HALF_CYCLE { do { g = *gpioInAddr; } while ( !( VIC_HALF_CYCLE( g ) ) ); }
-#define WAIT_FOR_CPU_HALF_CYCLE { do { g = *gpioInAddr; } while ( !( CPU_HALF_CYCLE( g ) ) ); }
+// BUS_PATH_MARK emits no code, only a comment in the assembly output (-save-temps) where Source/busCycles.py
+// starts and ends the paths it reports; "SLOW" marks operations which take longer than a bus cycle on purpose
+// (flash writes, reconfiguration), paths leading there are not checked against the budget. "DATA" marks the
+// point where a read's data is on the bus, busCycles.py reports the cycles up to there (no path ends there)
+#ifdef SKPICO_HOST
+// host bus model (host/busModel.c): instead of polling PHI2, handleBus() waits until the model presents the
+// next half-cycle of the requested phase (returns right away if the current one has it)
+extern uint32_t hostBusWaitHalfCycle( uint32_t phi2 );
+#define BUS_PATH_MARK( kind )
+#define WAIT_FOR_VIC_HALF_CYCLE { g = hostBusWaitHalfCycle( 0 ); }
+#define WAIT_FOR_CPU_HALF_CYCLE { g = hostBusWaitHalfCycle( bPHI ); }
+#else
+#define BUS_PATH_STR_( x )		#x
+#define BUS_PATH_STR( x )		BUS_PATH_STR_( x )
+#define BUS_PATH_MARK( kind )	asm volatile( "@ busPath " kind " " BUS_PATH_STR( __LINE__ ) );
+
+#define WAIT_FOR_VIC_HALF_CYCLE { do { g = *gpioInAddr; } while ( !( VIC_HALF_CYCLE( g ) ) ); BUS_PATH_MARK( "VIC" ) }
+#define WAIT_FOR_CPU_HALF_CYCLE { do { g = *gpioInAddr; } while ( !( CPU_HALF_CYCLE( g ) ) ); BUS_PATH_MARK( "CPU" ) }
+#endif
 
 #define SET_DATA( D )   \
       { sio_hw->gpio_set = ( D ); \
@@ -192,22 +213,26 @@ const __not_in_flash( "mydata" ) uint32_t  sidFlags[ 6 ] = { bSID, ( 1 << A5 ),
 extern uint32_t SID2_FLAG;
 extern uint8_t  SID2_IOx_global;
 
-// audio settings
-#define AUDIO_RATE (44100)
+// audio settings (output rate AUDIO_RATE from config, see reSIDWrapper.cc)
 #define AUDIO_VALS 2834
 #define AUDIO_BITS 11
 #define AUDIO_BIAS ( AUDIO_VALS / 2 )
 #define SAMPLES_PER_BUFFER (256)
 
 extern uint32_t C64_CLOCK;
+extern uint32_t AUDIO_RATE;
 
 #define SET_CLOCK_125MHZ set_sys_clock_pll( 1500000000, 6, 2 );
 #define SET_CLOCK_FAST   set_sys_clock_pll( 1500000000, 5, 1 );
 
+#ifdef SKPICO_HOST
+#define DELAY_Nx3p2_CYCLES( c )
+#else
 #define DELAY_Nx3p2_CYCLES( c )								\
     asm volatile( "mov  r0, %[_c]\n\t"							\
 				  "1: sub  r0, r0, #1\n\t"					\
 				  "bne   1b"  : : [_c] "r" (c) : "r0", "cc", "memory" );
+#endif
 
 
 void initGPIOs()
@@ -258,10 +283,11 @@ void initPotGPIOs()
 #ifdef USE_DAC
 
 audio_buffer_pool_t *ap;
+static audio_format_t audio_format = { .format = AUDIO_BUFFER_FORMAT_PCM_S16, .sample_freq = 44100, .channel_count = 2 };
 
 audio_buffer_pool_t *initI2S() 
 {
-	static audio_format_t audio_format = { .format = AUDIO_BUFFER_FORMAT_PCM_S16, .sample_freq = 44100, .channel_count = 2 };
+	audio_format.sample_freq = AUDIO_RATE;
 	static audio_buffer_format_t producer_format = { .format = &audio_format, .sample_stride = 8 };
 	audio_buffer_pool_t *pool = audio_new_producer_pool( &producer_format, 3, SAMPLES_PER_BUFFER ); 
 
@@ -281,6 +307,15 @@ audio_buffer_pool_t *initI2S()
 	return pool;
 }
 
+// switches the running I2S output to a new rate: same clock divider as audio_i2s_setup() uses (16.8 fixed point, 
+// the I2S program takes 64 PIO cycles per stereo sample), the state machine keeps running
+void setI2SRate( uint32_t rate )
+{
+	audio_format.sample_freq = rate;
+	uint32_t divider = clock_get_hz( clk_sys ) * 4 / rate;
+	pio_sm_set_clkdiv_int_frac( pio0, 0, divider >> 8, divider & 255 );
+}
+
 uint16_t audioPos = 0, 
 		 audioOutPos = 0;
 uint32_t audioBuffer[ SAMPLES_PER_BUFFER ];
@@ -292,10 +327,13 @@ uint8_t  firstOutput = 1;
 	removed for now
 #endif
 
-uint64_t c64CycleCounter = 0;
+// C64 cycles since power-up; 32 bit and wrapping (after ~72 minutes), compare time stamps only by differences
+uint32_t c64CycleCounter = 0;
 
-volatile int32_t newSample = 0xffff, newLEDValue;
-volatile uint64_t lastSIDEmulationCycle = 0;
+// PWM levels (audio, LED) taken from the sample FIFO at the last tick, output in the next cycle (0xffff: none)
+volatile int32_t newSample = 0xffff, newSampleLED;
+volatile int32_t newLEDValue;
+volatile uint32_t lastSIDEmulationCycle = 0;
 
 uint8_t outRegisters[ 34 * 2 ];
 uint8_t *outRegisters_2 = &outRegisters[ 34 ];
@@ -312,54 +350,28 @@ uint8_t hack_OPL_Sample_Enabled;
 #define REG_AUTO_DETECT_STEP		32
 #define REG_MODEL_DETECT_VALUE		33
 
+// last value written to the SID, read back from write-only registers until it decays after BUS_VALUE_TTL 
+// cycles (decided when reading, from the time stamp of the write)
+// fixed large value avoids artifacts in some old tunes (model dependent: 8580 0xa2000, 6581 0x1d00)
+#define BUS_VALUE_TTL	0x100000
 uint8_t busValue = 0;
-int32_t busValueTTL = 0;
+uint32_t busValueTime = 0;
 
 uint16_t SID_CMD = 0xffff;
 
-#define  RING_SIZE 256
-uint16_t ringBuf[ RING_SIZE ];
-uint32_t ringTime[ RING_SIZE ];
-uint8_t  ringWrite = 0;
-uint8_t  ringRead  = 0;
+#include "busRing.h"
+#include "sampleClock.h"
 
+SAMPLE_CLOCK sampleClock;
+
+// called on the bus side (handleBus(), configuration update) while the emulation core is running
 void resetEverything() 
 {
-	ringRead = ringWrite = 0;
+	ringFlush();
 }
 
 uint8_t stateGoingTowardsTransferMode = 0;
 
-typedef enum {
-	DD_IDLE = 0,
-	DD_PREP,
-	DD_CONF,
-	DD_PREP2,
-	DD_CONF2,
-	DD_SET,
-	DD_VAR1,
-	DD_VAR2
-} DD_STATE;
-
-DD_STATE ddTB_state[ 3 ] = { DD_IDLE, DD_IDLE, DD_IDLE };
-uint64_t ddTB_cycle[ 3 ] = { 0, 0, 0 };
-uint8_t  ddTB_sample[ 3 ] = { 0, 0, 0 };
-
-DD_STATE ddPWM_state[ 3 ] = { DD_IDLE, DD_IDLE, DD_IDLE };
-uint64_t ddPWM_cycle[ 3 ] = { 0, 0, 0 };
-uint8_t  ddPWM_sample[ 3 ] = { 0, 0, 0 };
-
-#define DD_TB_TIMEOUT0	135
-// def 22 and 12
-#define DD_TB_TIMEOUT	22
-#define DD_PWM_TIMEOUT	22
-
-uint8_t  ddActive[ 3 ];
-uint64_t ddCycle[ 3 ] = { 0, 0, 0 };
-uint8_t	 sampleValue[ 3 ] = { 0 };
-
-extern void outputDigi( uint8_t voice, int32_t value );
-
 extern uint8_t POT_FILTER_global;
 uint8_t paddleFilterMode = 0;
 uint8_t SID2_IOx;
@@ -425,6 +437,8 @@ inline uint8_t median( uint8_t *x )
 	int16_t ramp = 0, rampDelta = 0;
 	int16_t lerp = RAMP_LENGTH, lerpTarget = 0, lerpDelta = -4;
 
+#include "emulationCore.h"
+
 void runEmulation()
 {
 	irq_set_mask_enabled( 0xffffffff, 0 );
@@ -503,16 +517,14 @@ void runEmulation()
 	pio_sm_put( pio0, 1, 0 );
 	#endif
 
-	#ifdef SID_DAC_MODE_SUPPORT
-	int32_t DAC_L = 0, DAC_R = 0;
-	#endif
-
-	extern uint8_t SID_DIGI_DETECT;	// from config: heuristics activated?
-	uint8_t  sampleTechnique = 0;
+	// state of the emulation core (see emulationCore.h)
+	EMU_CORE_STATE emu;
+	memset( &emu, 0, sizeof( EMU_CORE_STATE ) );
+	emu.pOPL = pOPL;
+	emu.audioRate = AUDIO_RATE;
 
-	uint64_t lastD418Cycle = 0;
-	#ifdef USE_RGB_LED
-	uint8_t  digiD418Visualization = 0;
+	#ifdef EMU_PROFILING
+	emuProfileInit();
 	#endif
 
 	uint8_t potXHistory[ 3 ], potYHistory[ 3 ], potHistoryCnt = 0;
@@ -630,274 +642,19 @@ void runEmulation()
 		}
 	#endif
 
-		uint64_t targetEmulationCycle = c64CycleCounter;
-		while ( ringRead != ringWrite )
-		{
-			#ifdef SID_DAC_MODE_SUPPORT
-			// this is placed here, as we don't use time stamps in DAC mode
-			if ( sidDACMode && !( ringBuf[ ringRead ] & ( 1 << 15 ) ) )
-			{
-				register uint16_t cmd = ringBuf[ ringRead ++ ];
-				uint8_t reg = ( cmd >> 8 ) & 0x1f;
-
-				if ( sidDACMode == SID_DAC_STEREO8 )
-				{
-					if ( reg == 0x18 )
-						DAC_L = ( (int)( cmd & 255 ) - 128 ) << 7;
-					if ( reg == 0x19 )
-						DAC_R = ( (int)( cmd & 255 ) - 128 ) << 7; 
-				} else
-				if ( sidDACMode == SID_DAC_MONO8 && reg == 0x18 )
-				{
-					DAC_L = DAC_R = ( (int)( cmd & 255 ) - 128 ) << 7;
-				}
-				continue;
-			} 
-			#endif
-
-
-			uint64_t cmdTime = (uint64_t)ringTime[ ringRead ];
-
-			if ( cmdTime > lastSIDEmulationCycle )
-			{
-				targetEmulationCycle = cmdTime;
-				break;
-			}
-			
-			register uint16_t cmd = ringBuf[ ringRead ++ ];
-
-			if ( cmd & ( 1 << 15 ) )
-			{
-				#ifdef U64BOARD
-				if ( FM_DYNAMIC_ENABLE )
-				#else
-				if ( FM_ENABLE )
-				#endif
-				{
-					ym3812_write( pOPL, ( ( cmd >> 8 ) >> 4 ) & 1, cmd & 255 );
-				} else
-				{
-					writeReSID2( ( cmd >> 8 ) & 0x1f, cmd & 255 );
-				}
-			} else
-			{
-				uint8_t reg = cmd >> 8;
-
-				// this is a work-around if very early writes to SID-registers are missed due to boot-up time (and d418 is only set once)
-			#ifndef RESET_ON_GPIO
-				static uint8_t d418_volume_set = 0;
-				if ( !d418_volume_set )
-				{
-					if ( reg == 0x18 ) d418_volume_set = 1;
-					if ( ringRead == 33 )
-						writeReSID( 0x18, 15 );
-				}
-			#endif
-
-				#ifdef USE_RGB_LED
-				if ( reg == 0x18 )
-				{
-					if ( ( targetEmulationCycle - lastD418Cycle ) < 1536 )
-					{
-						digiD418Visualization = 1;
-
-						// heuristic to detect Mahoney's technique based on findings by Jürgen Wothke used in WebSid (https://bitbucket.org/wothke/websid/src/master/) )
-						if ( ( 0x17[ outRegisters ] == 0x3 ) && ( 0x15[ outRegisters ] >= 0xfe ) && ( 0x16[ outRegisters ] >= 0xfe ) &&
-							 ( 0x06[ outRegisters ] >= 0xfb ) && ( 0x06[ outRegisters ] == 0x0d[ outRegisters ] ) && ( 0x06[ outRegisters ] == 0x14[ outRegisters ] ) &&
-							 ( 0x04[ outRegisters ] == 0x49 ) && ( 0x0b[ outRegisters ] == 0x49 ) && ( 0x12[ outRegisters ] == 0x49 ) )
-							digiD418Visualization = 2;
-					} else
-						digiD418Visualization = 0;
-
-					lastD418Cycle = targetEmulationCycle;
-				}
-				#endif
-
-				writeReSID( reg, cmd & 255 );
-
-				// pseudo stereo
-				if ( SID2_FLAG == ( 1 << 31 ) )
-					writeReSID2( reg, cmd & 255 );
-
-				#ifdef SUPPORT_DIGI_DETECT
-
-				//
-				// Digi-Playing Detection to bypass reSID
-				// (the heuristics below are based on the findings by J�rgen Wothke used in WebSid (https://bitbucket.org/wothke/websid/src/master/) )
-				//
-
-				if ( SID_DIGI_DETECT )
-				{
-					uint8_t voice = 0;
-					if ( reg >  6 && reg < 14 ) { voice = 1; reg -= 7; }
-					if ( reg > 13 && reg < 21 ) { voice = 2; reg -= 14; }
-
-					//
-					// test-bit technique
-
-					#define DD_STATE_TBC( state, cycle )	{ ddTB_state[ voice ] = state; ddTB_cycle[ voice ] = cycle; }
-					#define DD_STATE_TB( state )			{ ddTB_state[ voice ] = state; }
-					#define DD_NO_TIMEOUT( threshold )		( ( c64CycleCounter - ddTB_cycle[ voice ] ) < threshold )
-					
-					#define DD_GET_SAMPLE( s )	{	DD_STATE_TBC( DD_IDLE, 0 );					\
-													ddActive[ voice ] = sampleTechnique = 2;	\
-													sampleValue[ voice ] = s;					\
-													ddCycle[ voice ] = c64CycleCounter; }
-
-					if ( reg == 4 )	
-					{	
-						uint8_t v = cmd & 0x19;
-						switch ( v ) 
-						{
-						case 0x11:	
-							DD_STATE_TBC( DD_PREP, c64CycleCounter );
-							break;
-						case 0x8: case 0x9:	
-							if ( ddTB_state[ voice ] == DD_PREP && DD_NO_TIMEOUT( DD_TB_TIMEOUT0 ) )
-								DD_STATE_TBC( DD_SET, c64CycleCounter - 4 ) else
-								DD_STATE_TB( DD_IDLE )
-							break;
-						case 0x1:	// GATE
-							if ( ddTB_state[ voice ] == DD_SET && DD_NO_TIMEOUT( DD_TB_TIMEOUT ) )
-								DD_STATE_TB( DD_VAR1 ) else
-							if ( ddTB_state[ voice ] == DD_VAR2 && DD_NO_TIMEOUT( DD_TB_TIMEOUT ) )
-								DD_GET_SAMPLE( ddTB_sample[ voice ] ) else
-								DD_STATE_TB( DD_IDLE )
-							break;
-						case 0x0:	
-							if ( ddTB_state[ voice ] == DD_VAR2 && DD_NO_TIMEOUT( DD_TB_TIMEOUT ) )
-								DD_GET_SAMPLE( ddTB_sample[ voice ] )
-							break;
-						}
-					} else
-					if ( reg == 1 ) 
-					{	
-						if ( ddTB_state[ voice ] == DD_SET && DD_NO_TIMEOUT( DD_TB_TIMEOUT ) )
-						{
-							ddTB_sample[ voice ] = cmd & 255;
-							DD_STATE_TBC( DD_VAR2, c64CycleCounter )
-						} else 
-						if ( ddTB_state[ voice ] == DD_VAR1 && DD_NO_TIMEOUT( DD_TB_TIMEOUT ) )
-							DD_GET_SAMPLE( cmd & 255 )
-					}
-
-					//
-					// pulse modulation technique
-					
-					#define DD_PWM_STATE_TBC( state, cycle )	{ ddPWM_state[ voice ] = state; ddPWM_cycle[ voice ] = cycle; }
-					#define DD_PWM_STATE_TB( state )			{ ddPWM_state[ voice ] = state; }
-					#define DD_PWM_NO_TIMEOUT( threshold )		( ( c64CycleCounter - ddPWM_cycle[ voice ] ) < threshold )
-
-					#define DD_PWM_GET_SAMPLE( s )	{	DD_PWM_STATE_TBC( DD_IDLE, 0 );				\
-														ddActive[ voice ] = sampleTechnique = 1;	\
-														sampleValue[ voice ] = s;					\
-														ddCycle[ voice ] = c64CycleCounter; }
-
-					if ( reg == 4 ) 
-					{
-						uint8_t v = cmd & 0x49;	
-						switch ( v ) 
-						{
-						case 0x49:	
-							if ( ( ddPWM_state[ voice ] == DD_PREP ) && DD_PWM_NO_TIMEOUT( DD_PWM_TIMEOUT ) )
-								DD_PWM_STATE_TBC( DD_CONF, c64CycleCounter ) else
-								DD_PWM_STATE_TBC( DD_PREP2, c64CycleCounter ) 
-							break;
-						case 0x41:	
-							if ( ( ddPWM_state[ voice ] == DD_CONF || ddPWM_state[ voice ] == DD_CONF2 ) && DD_PWM_NO_TIMEOUT( DD_PWM_TIMEOUT ) )
-								DD_PWM_GET_SAMPLE( ddPWM_sample[ voice ] ) else
-								DD_PWM_STATE_TB( DD_IDLE )
-							break;
-						}
-					} else 
-					if ( reg == 2 ) 
-					{
-						if ( ( ddPWM_state[ voice ] == DD_PREP2 ) && DD_PWM_NO_TIMEOUT( DD_PWM_TIMEOUT ) )
-							DD_PWM_STATE_TBC( DD_CONF2, c64CycleCounter ) else
-							DD_PWM_STATE_TBC( DD_PREP, c64CycleCounter )
-						ddPWM_sample[ voice ] = cmd & 255;
-					}
-				}
-				#endif
-			}
-		} // while
-
-		uint64_t curCycleCount = targetEmulationCycle;
-
-		#ifdef SID_DAC_MODE_SUPPORT
-		if ( !sidDACMode )
-		#endif
-		if ( lastSIDEmulationCycle < curCycleCount )
-		{
-			#ifdef SUPPORT_DIGI_DETECT
-			if ( SID_DIGI_DETECT )
-			{
-				uint16_t v;
-
-				if ( c64CycleCounter - ddCycle[ 0 ] > 250 ) { ddActive[ 0 ] = 0; outputDigi( 0, 0 ); }
-				if ( c64CycleCounter - ddCycle[ 1 ] > 250 ) { ddActive[ 1 ] = 0; outputDigi( 1, 0 ); }
-				if ( c64CycleCounter - ddCycle[ 2 ] > 250 ) { ddActive[ 2 ] = 0; outputDigi( 2, 0 ); }
+		// with a sample due, the emulation stops at the cycle of its tick and renders it there (after as many
+		// passes as there are commands before), otherwise it runs up to the current cycle. The cycle is read
+		// first: a tick up to then has been requested when sampleFifoDue() looks
+		uint32_t now = c64CycleCounter, sampleCycle;
+		uint32_t sampleDue = sampleFifoDue( &sampleCycle );
 
-				if ( ddActive[ 0 ] ) { *(int16_t *)&v = ( sampleValue[ 0 ] - 128 ) << 8; v &= ~3; v |= sampleTechnique; outputDigi( 0, *(int16_t *)&v ); }
-				if ( ddActive[ 1 ] ) { *(int16_t *)&v = ( sampleValue[ 1 ] - 128 ) << 8; v &= ~3; v |= sampleTechnique; outputDigi( 1, *(int16_t *)&v ); }
-				if ( ddActive[ 2 ] ) { *(int16_t *)&v = ( sampleValue[ 2 ] - 128 ) << 8; v &= ~3; v |= sampleTechnique; outputDigi( 2, *(int16_t *)&v ); }
-
-				#ifdef USE_RGB_LED
-				if ( sampleTechnique == 1 ) digiD418Visualization = 2;
-				#endif
-			}
-			#endif
-
-			uint64_t cyclesToEmulate = curCycleCount - lastSIDEmulationCycle;
-			lastSIDEmulationCycle = curCycleCount;
-			#ifdef U64BOARD
-			if ( FM_DYNAMIC_ENABLE )
-				emulateCyclesReSIDSingle( cyclesToEmulate ); else
-				emulateCyclesReSID( cyclesToEmulate );
-			#else
-			if ( FM_ENABLE )
-				emulateCyclesReSIDSingle( cyclesToEmulate ); else
-				emulateCyclesReSID( cyclesToEmulate );
-			#endif
-			readRegs( &outRegisters[ 0x1b ], &outRegisters_2[ 0x1b ] );
-		}
-
-
-		if ( newSample == 0xfffe )
+		if ( emulationDrainRing( &emu, sampleDue ? sampleCycle : now ) && sampleDue )
 		{
 			int16_t L, R;
 
-			#ifdef SID_DAC_MODE_SUPPORT
-			if ( sidDACMode )
-			{
-				L = DAC_L;
-				R = DAC_R;
-				#ifdef USE_RGB_LED
-				digiD418Visualization = 2;
-				#endif
-			} else
-			#endif
-			#ifdef U64BOARD
-			if ( FM_DYNAMIC_ENABLE )
-			#else
-			if ( FM_ENABLE )
-			#endif
-			{
-				OPLSAMPLE fm;
-				ym3812_update_one( pOPL, &fm, 1 );
-
-				if ( hack_OPL_Sample_Enabled )
-					fm = ( (uint16_t)hack_OPL_Sample_Value[ 0 ] << 5 ) + ( (uint16_t)hack_OPL_Sample_Value[ 1 ] << 5 );
+			sampleFifoTake();
 
-				#ifdef U64BOARD
-				extern void outputReSIDFMU64( int16_t * left, int16_t * right, int32_t fm, uint8_t fmHackEnable, uint8_t *fmDigis );
-				outputReSIDFMU64( &L, &R, (int32_t)fm, hack_OPL_Sample_Enabled, hack_OPL_Sample_Value );
-				#else
-				extern void outputReSIDFM( int16_t * left, int16_t * right, int32_t fm, uint8_t fmHackEnable, uint8_t *fmDigis );
-				outputReSIDFM( &L, &R, (int32_t)fm, hack_OPL_Sample_Enabled, hack_OPL_Sample_Value );
-				#endif
-			} else
-				outputReSID( &L, &R );
+			emulationOutputSample( &emu, &L, &R );
 
 			// PWM output via C64/C128 mainboard
 			int32_t s_ = L + R;
@@ -914,9 +671,15 @@ void runEmulation()
 				s = t;
 			}
 
-			newSample = s;
+			#if defined( OUTPUT_VIA_PWM ) || defined( FLASH_LED )
+			uint16_t pwmLevel = s;
+			#endif
 
 			#if defined( USE_DAC ) 
+			EMU_PROFILE_START( tAudioOut )
+
+			if ( audio_format.sample_freq != emu.audioRate )
+				setI2SRate( emu.audioRate );
 
 			// fill buffer, skip/stretch as needed
 			if ( audioPos < 256 )
@@ -948,6 +711,7 @@ void runEmulation()
 				audioOutPos = audioPos = 0;
 			}
 
+			EMU_PROFILE_END( PROF_AUDIO_OUT, tAudioOut )
 			#endif
 			
 			#if defined( USE_SPDIF )
@@ -962,7 +726,12 @@ void runEmulation()
 			s >>= ( AUDIO_BITS - 5 );
 			newLEDValue += s;
 
+			#if defined( OUTPUT_VIA_PWM ) || defined( FLASH_LED )
+			sampleFifoPush( pwmLevel, newLEDValue );
+			#endif
+
 			#ifdef USE_RGB_LED
+			EMU_PROFILE_START( tLED )
 			extern int32_t voiceOutAcc[ 3 ], nSamplesAcc;
 
 			#define SAMPLE2BRIGHTNESS( _s, res ) {					\
@@ -976,7 +745,7 @@ void runEmulation()
 			int32_t r, g, b;
 
 			// no LEDs from voice output when using Mahoney's digi technique or PWM techniques
-			if ( digiD418Visualization < 2 )
+			if ( emu.digiD418Visualization < 2 )
 			{
 				SAMPLE2BRIGHTNESS( voiceOutAcc[ 0 ] >> 2, r );
 				SAMPLE2BRIGHTNESS( voiceOutAcc[ 1 ] >> 2, g );
@@ -986,10 +755,10 @@ void runEmulation()
 				b_ += b;
 			}
 
-			if ( digiD418Visualization )
+			if ( emu.digiD418Visualization )
 			{
 				int32_t t = newLEDValue << 7;
-				if ( digiD418Visualization == 1 ) t <<= 4;
+				if ( emu.digiD418Visualization == 1 ) t <<= 4;
 				r_ += t;
 				g_ += t;
 				b_ += t;
@@ -1004,6 +773,11 @@ void runEmulation()
 				r_ = g_ = b_ = 0;
 				smpCnt = 0;
 			}
+			EMU_PROFILE_END( PROF_LED, tLED )
+			#endif
+
+			#ifdef EMU_PROFILING
+			emuProfileSampleDone();
 			#endif
 		}
 	}
@@ -1025,7 +799,7 @@ uint8_t  transferReg[ 32 ] = {
 
 const uint8_t __not_in_flash( "mydata" ) jmpCode[ 3 ] = { 0x4c, 0x00, 0xd4 }; // jmp $d400
 static uint32_t resetCnt32 = 0;
-static volatile uint32_t noSIDAccessCounter = 0;
+static volatile uint32_t lastSIDAccessCycle = 0;
 static volatile uint32_t launchConfigEnabled = 2;
 
 void handleBus()
@@ -1046,15 +820,22 @@ void handleBus()
 	outRegisters[ REG_MODEL_DETECT_VALUE ] = ( config[ /*CFG_SID1_TYPE*/0 ] == 0 ) ? SID_MODEL_DETECT_VALUE_6581 : SID_MODEL_DETECT_VALUE_8580;
 	outRegisters[ REG_MODEL_DETECT_VALUE + 34 ] = ( config[ /*CFG_SID2_TYPE*/8 ] == 0 ) ? SID_MODEL_DETECT_VALUE_6581 : SID_MODEL_DETECT_VALUE_8580;
 
-	register uint32_t gpioDir = bOE | bPWN_POT | ( 1 << LED_BUILTIN ), gpioDirCur = 0;
+	register uint32_t gpioDir = bOE | bPWN_POT | ( 1 << LED_BUILTIN );
 	register uint32_t g;
 	register uint32_t A;
 	register uint8_t  DELAY_READ_BUS_local = DELAY_READ_BUS,
 		DELAY_PHI2_local = DELAY_PHI2;
 	register uint8_t  D;
 	volatile const uint32_t *gpioInAddr = &sio_hw->gpio_in;
+	// work for the next VIC-halfcycle, such that the common case is a single test
+	#define PENDING_DATA_LINES	1		// release the data lines
+	#define PENDING_POT_DIR		2		// gpioDir changed (POTX/POTY measurement phase)
 	register volatile uint8_t newPotCounter = 0, disableDataLines = 0;
-	register uint32_t curSample = 0;
+	register uint32_t nextSampleCycle = sampleClockStart( &sampleClock, c64CycleCounter );
+
+	// reset line: the time stamp when it went low, the duration is computed while held and on release
+	register uint8_t  resetHeld = 0;
+	register uint32_t resetStart = 0;
 
 	// variables for potentiometer handling and filtering
 	uint8_t potCycleCounter = 0;
@@ -1091,7 +872,11 @@ void handleBus()
 handleSIDCommunication:
 
 	resetCnt32 = 0;
-	noSIDAccessCounter = 0;	
+	resetHeld = 0;
+	lastSIDAccessCycle = c64CycleCounter;
+
+	// (re)apply the pin directions, transfer and config mode do not track them
+	disableDataLines |= PENDING_POT_DIR;
 
 	if ( !prgLaunch && currentPRG != 255 )
 	{
@@ -1127,97 +912,106 @@ handleSIDCommunication:
 
 		if ( disableDataLines )
 		{
-			gpio_set_dir_masked( 0xff, 0 );
-			disableDataLines = 0;
-
-			if ( stateGoingTowardsTransferMode == 3 )
+			if ( disableDataLines & PENDING_DATA_LINES )
 			{
-				stateInConfigMode = TRANSFER_MODE_CYCLES;
-				if ( launchConfigEnabled ) launchConfigEnabled --;
-				goto transferWaitForCPU_Halfcycle;
-			}
-		}
+				gpio_set_dir_masked( 0xff, 0 );
 
-		if ( gpioDir != gpioDirCur )
-		{
-			gpioDirCur = gpioDir;
+				if ( stateGoingTowardsTransferMode == 3 )
+				{
+					disableDataLines = 0;
+					stateInConfigMode = TRANSFER_MODE_CYCLES;
+					if ( launchConfigEnabled ) launchConfigEnabled --;
+					goto transferWaitForCPU_Halfcycle;
+				}
+			}
 
-			if ( config[ 57 ] )
+			if ( disableDataLines & PENDING_POT_DIR )
 			{
-				if ( gpioDir & bPOTY )
+				if ( config[ 57 ] )
 				{
+					if ( gpioDir & bPOTY )
+					{
+						#if defined( SKPICO_2350CR ) || defined( SKPICO_2350 )
+						io_bank0_hw->io[ POTY ].ctrl = GPIO_FUNC_SIO << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+						#else
+						iobank0_hw->io[ POTY ].ctrl = GPIO_FUNC_SIO << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+						#endif
+						gpio_set_dir_masked( bPOTY, 0xffffffff );
+					} else
+					{
+						#if defined( SKPICO_2350CR ) || defined( SKPICO_2350 )
+						io_bank0_hw->io[ POTY ].ctrl = GPIO_FUNC_NULL << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+						#else
+						iobank0_hw->io[ POTY ].ctrl = GPIO_FUNC_NULL << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+						//hw_clear_bits( &padsbank0_hw->io[ POTY ], PADS_BANK0_GPIO0_IE_BITS );
+						#endif
+					}
+
 					#if defined( SKPICO_2350CR ) || defined( SKPICO_2350 )
-					io_bank0_hw->io[ POTY ].ctrl = GPIO_FUNC_SIO << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+					gpio_set_dir_masked64( bPOTX, gpioDir );
 					#else
-					iobank0_hw->io[ POTY ].ctrl = GPIO_FUNC_SIO << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+					gpio_set_dir_masked( bPOTX, gpioDir );
 					#endif
-					gpio_set_dir_masked( bPOTY, 0xffffffff );
 				} else
 				{
 					#if defined( SKPICO_2350CR ) || defined( SKPICO_2350 )
-					io_bank0_hw->io[ POTY ].ctrl = GPIO_FUNC_NULL << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
+					gpio_set_dir_masked64( bPOTX | bPOTY, gpioDir );
 					#else
-					iobank0_hw->io[ POTY ].ctrl = GPIO_FUNC_NULL << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
-					//hw_clear_bits( &padsbank0_hw->io[ POTY ], PADS_BANK0_GPIO0_IE_BITS );
+					gpio_set_dir_masked( bPOTX | bPOTY, gpioDir );
 					#endif
 				}
-
-				#if defined( SKPICO_2350CR ) || defined( SKPICO_2350 )
-				gpio_set_dir_masked64( bPOTX, gpioDir );
-				#else
-				gpio_set_dir_masked( bPOTX, gpioDir );
-				#endif
-			} else
-			{
-				#if defined( SKPICO_2350CR ) || defined( SKPICO_2350 )
-				gpio_set_dir_masked64( bPOTX | bPOTY, gpioDir );
-				#else
-				gpio_set_dir_masked( bPOTX | bPOTY, gpioDir );
-				#endif
 			}
-		}
 
+			disableDataLines = 0;
+		}
 
+		#if defined( OUTPUT_VIA_PWM ) || defined( FLASH_LED )
 		if ( newSample < 0xfffe )
 		{
 			#ifdef OUTPUT_VIA_PWM
 			pwm_set_gpio_level( AUDIO_PIN, newSample );
 			#endif
 			#ifdef FLASH_LED
-			pwm_set_gpio_level( LED_BUILTIN, newLEDValue );
+			pwm_set_gpio_level( LED_BUILTIN, newSampleLED );
 			#endif
 
 			newSample = 0xffff;
 		}
+		#endif
 
-		// we have to generate a new sample after C64_CLOCK / AUDIO_RATE cycles
-		++ c64CycleCounter;
-		curSample += AUDIO_RATE;
-		if ( curSample > C64_CLOCK )
+		// we have to generate a new sample after C64_CLOCK / AUDIO_RATE cycles (see sampleClock.h)
+		if ( SAMPLE_DUE( ++ c64CycleCounter, nextSampleCycle ) )
 		{
-			curSample -= C64_CLOCK;
-			newSample = 0xfffe;
+			nextSampleCycle = sampleClockAdvance( &sampleClock, nextSampleCycle, c64CycleCounter );
+			#if defined( OUTPUT_VIA_PWM ) || defined( FLASH_LED )
+			uint16_t v[ 2 ];
+			if ( sampleFifoTick( c64CycleCounter, v ) )
+			{
+				newSample = v[ 0 ];
+				newSampleLED = v[ 1 ];
+			}
+			#else
+			sampleFifoRequest( c64CycleCounter );
+			#endif
 		}
 
-		if ( busValueTTL < 0 )
-		{
-			busValue = 0;
-		} else
-			busValueTTL --;
-
 	#ifdef RESET_ON_GPIO
 		#define MILLISECONDS_TO_TIMING_CHANGE	( 4*1000000)
 		#define MILLISECONDS_TO_FACTORY_RESET	( 8*1000000)
 
-		static uint16_t resetCnt = 0;
+		// resetCnt32 = cycles the reset line has been held low, only maintained while it is
 		if ( SID_RESET( g ) )
 		{
 			launchConfigEnabled = 2;
 
-			resetCnt32 ++;
-			if ( resetCnt < 30000 ) 
-				resetCnt ++; 
-			if ( resetCnt > 4 ) 
+			if ( !resetHeld )
+			{
+				resetHeld = 1;
+				resetStart = c64CycleCounter;
+			}
+			resetCnt32 = c64CycleCounter - resetStart + 1;
+
+			if ( resetCnt32 > 4 ) 
 			{ 
 				lerp = 4;
 				lerpDelta = 4;
@@ -1244,10 +1038,14 @@ handleSIDCommunication:
 				lastLEDValue = newLEDValue;
 				pwm_set_gpio_level( LED_BUILTIN, newLEDValue );
 			}
+			// the LED shows the reset progress, drop the sample taken at this tick
 			newSample = 0xfffe;
 			#endif
 		} else
+		if ( resetHeld )
 		{
+			resetHeld = 0;
+
 			if ( resetCnt32 >= MILLISECONDS_TO_FACTORY_RESET )
 			{
 				doReset = 2;
@@ -1256,18 +1054,17 @@ handleSIDCommunication:
 			{
 				doReset = 3;
 			} else 
-			if ( resetCnt >= 2500 )
+			if ( resetCnt32 >= 2500 )
 			{
 				doReset = 1;
 			#ifdef MEANINGFUL_RESET
-				ringWrite = 0;
+				ringFlush();
 				c64CycleCounter = 0;
+				nextSampleCycle = sampleClockStart( &sampleClock, 0 );
 				busValue = 0;
 			#endif
 			}
-			resetCnt = resetCnt32 = 0;
-
-			resetCnt = 0;
+			resetCnt32 = 0;
 		}
 
 	#endif
@@ -1337,7 +1134,7 @@ handleSIDCommunication:
 				{
 					gpio_set_dir_masked( 0xff, 0xff );
 					//if ( A >= 0x1d )
-					if ( ( A == 0x1d && launchConfigEnabled /*&& noSIDAccessCounter > 8*/ ) || A >= 0x1e )
+					if ( ( A == 0x1d && launchConfigEnabled /*&& c64CycleCounter - lastSIDAccessCycle > 8*/ ) || A >= 0x1e )
 					{
 						D = jmpCode[ A - 0x1d ];
 						stateGoingTowardsTransferMode ++;
@@ -1349,13 +1146,18 @@ handleSIDCommunication:
 							D = reg[ REG_MODEL_DETECT_VALUE ];
 						} else
 						{
-							if ( A >= 0x19 && A <= 0x1c )
+							if ( A >= 0x1b && A <= 0x1c )
+								D = voice3AheadRead( reg, A, c64CycleCounter ); else
+							if ( A >= 0x19 && A <= 0x1a )
 								D = reg[ A ]; else
-								D = busValue;
+								D = ( c64CycleCounter - busValueTime ) <= BUS_VALUE_TTL ? busValue : 0;
 						}
 						stateGoingTowardsTransferMode = 0;
 					}
 					SET_DATA( D );
+					BUS_PATH_MARK( "DATA" )
+					if ( A >= 0x1b && A <= 0x1c )
+						voice3AheadPolled( reg );
 					disableDataLines = 1;
 				}
 			} else
@@ -1392,8 +1194,9 @@ handleSIDCommunication:
 					{
 						doReset = 1;
 					#ifdef MEANINGFUL_RESET
-						ringWrite = 0;
+						ringFlush();
 						c64CycleCounter = 0;
+						nextSampleCycle = sampleClockStart( &sampleClock, 0 );
 						busValue = 0;
 					#endif
 					}
@@ -1433,8 +1236,7 @@ handleSIDCommunication:
 							}
 
 							SID_CMD = ( A << 8 ) | D | ( 1 << 15 );
-							ringTime[ ringWrite ] = (uint64_t)c64CycleCounter;
-							ringBuf[ ringWrite ++ ] = SID_CMD;
+							ringPush( SID_CMD, c64CycleCounter );
 						}
 
 						if ( ( g & ( 1 << ( A0 + 4 ) ) ) == 0 && D == 0x04 )
@@ -1454,8 +1256,7 @@ handleSIDCommunication:
 						SID_CMD = ( A << 8 ) | D;
 						if ( g & SID2_FLAG ) SID_CMD |= 1 << 15;
 
-						ringTime[ ringWrite ] = (uint64_t)c64CycleCounter;
-						ringBuf[ ringWrite ++ ] = SID_CMD;
+						ringPush( SID_CMD, c64CycleCounter );
 
 						if ( REG_AUTO_DETECT_STEP[ reg ] == 0 &&
 							 0x12[ reg ] == 0xff &&
@@ -1471,18 +1272,11 @@ handleSIDCommunication:
 				}
 				disableDataLines = 1;
 				busValue = D;
-				//if ( outRegisters[ REG_MODEL_DETECT_VALUE ] == SID_MODEL_DETECT_VALUE_8580 )
-					//busValueTTL = 0xa2000; else
-					//busValueTTL = 0x1d00;
-
-				// fixed large value avoids artifacts in some old tunes
-				busValueTTL = 0x100000;
+				busValueTime = c64CycleCounter;
 			}
 
-			noSIDAccessCounter = 0;
-
-		} else
-			noSIDAccessCounter++;
+			lastSIDAccessCycle = c64CycleCounter;
+		}
 
 		/*   __   __  ___  ___      ___    __         ___ ___  ___  __
 			|__) /  \  |  |__  |\ |  |  | /  \  |\/| |__   |  |__  |__)
@@ -1493,6 +1287,7 @@ handleSIDCommunication:
 			if ( newPotCounter & 4 )			// in phase 2?
 			{
 				gpioDir |= bPOTX | bPOTY;       // enter phase 1
+				disableDataLines |= PENDING_POT_DIR;
 				newPotCounter = 0;
 
 				if ( POT_OUTLIER_REJECTION > 1 )
@@ -1560,6 +1355,7 @@ handleSIDCommunication:
 			} else
 			{
 				gpioDir &= ~( bPOTX | bPOTY );  // enter phase 2
+				disableDataLines |= PENDING_POT_DIR;
 				newPotCounter = 0b111;
 			}
 		} else
@@ -1737,25 +1533,34 @@ handleSIDCommunication:
 			gpio_set_dir_masked( 0xff, 0 );
 		}
 
+		#if defined( OUTPUT_VIA_PWM ) || defined( FLASH_LED )
 		if ( newSample < 0xfffe )
 		{
 			#ifdef OUTPUT_VIA_PWM
 			pwm_set_gpio_level( AUDIO_PIN, newSample );
 			#endif
 			#ifdef FLASH_LED
-			pwm_set_gpio_level( LED_BUILTIN, newLEDValue );
+			pwm_set_gpio_level( LED_BUILTIN, newSampleLED );
 			#endif
 
 			newSample = 0xffff;
 		}
+		#endif
 
-		// we have to generate a new sample after C64_CLOCK / AUDIO_RATE cycles
-		++ c64CycleCounter;
-		curSample += AUDIO_RATE;
-		if ( curSample > C64_CLOCK )
+		// we have to generate a new sample after C64_CLOCK / AUDIO_RATE cycles (see sampleClock.h)
+		if ( SAMPLE_DUE( ++ c64CycleCounter, nextSampleCycle ) )
 		{
-			curSample -= C64_CLOCK;
-			newSample = 0xfffe;
+			nextSampleCycle = sampleClockAdvance( &sampleClock, nextSampleCycle, c64CycleCounter );
+			#if defined( OUTPUT_VIA_PWM ) || defined( FLASH_LED )
+			uint16_t v[ 2 ];
+			if ( sampleFifoTick( c64CycleCounter, v ) )
+			{
+				newSample = v[ 0 ];
+				newSampleLED = v[ 1 ];
+			}
+			#else
+			sampleFifoRequest( c64CycleCounter );
+			#endif
 		}
 
 	configWaitForCPU_Halfcycle:
@@ -1786,6 +1591,13 @@ handleSIDCommunication:
 				{
 					if ( stateConfigRegisterAccess < 65536 )
 						D = config[ ( stateConfigRegisterAccess ++ ) & 63 ]; else
+						#ifdef EMU_PROFILING
+						if ( stateConfigRegisterAccess >= 65536 + 31 )
+						{
+							uint32_t i = ( stateConfigRegisterAccess ++ ) - 65536 - 31;
+							D = i < EMU_PROFILE_EXPORT_SIZE ? emuProfileExport[ i ] : 0;
+						} else
+						#endif
 						//if ( stateConfigRegisterAccess < 65536 + VERSION_STR_SIZE )
 							D = VERSION_STR[ stateConfigRegisterAccess - 65536 ];
 					stateInConfigMode = CONFIG_MODE_CYCLES;
@@ -1837,6 +1649,9 @@ handleSIDCommunication:
 					if ( D >= 224 )
 						stateConfigRegisterAccess = 65536 - 224 + D; else
 						stateConfigRegisterAccess = D * 64;
+					#ifdef EMU_PROFILING
+					if ( D == 255 ) emuProfileRestart = 1;
+					#endif
 					stateInConfigMode = CONFIG_MODE_CYCLES;
 
 					addrLines |= ( g >> A5 ) & 3;
@@ -1845,6 +1660,7 @@ handleSIDCommunication:
 				{
 					if ( D >= 0xfe )
 					{
+						BUS_PATH_MARK( "SLOW" )
 						// update settings and write / do not write to flash
 						// TODO
 						updateConfiguration();
@@ -1909,6 +1725,7 @@ handleSIDCommunication:
 				} else
 				if ( A == 0x17 ) // end PRG upload, or end of bus timing banging!
 				{
+					BUS_PATH_MARK( "SLOW" )
 					SET_CLOCK_125MHZ
 					DELAY_Nx3p2_CYCLES( 85000 );
 
@@ -1979,6 +1796,7 @@ handleSIDCommunication:
 				} else
 				if ( A == 0x10 )
 				{
+					BUS_PATH_MARK( "SLOW" )
 					SET_CLOCK_125MHZ
 					DELAY_Nx3p2_CYCLES( 85000 );
 					const uint8_t *dirEntry = &prgDirectory[ D * 24 ];
@@ -2032,6 +1850,9 @@ void readConfiguration()
 		setDefaultConfiguration();
 	} else
 	{
+		extern void validateConfiguration();
+		validateConfiguration();
+
         if ( config[ CFG_CUSTOM_USE_TIMINGS ] )
 		{
         	DELAY_READ_BUS = config[ CFG_CUSTOM_TIMING_READBUS ];
@@ -2055,6 +1876,8 @@ void writeConfiguration()
 
 
 
+// the host bus model (host/busModel.c) sets up the firmware and starts handleBus() itself
+#ifndef SKPICO_HOST
 int main()
 {
 	vreg_set_voltage( VREG_VOLTAGE_1_30 );
@@ -2077,3 +1900,4 @@ int main()
 #endif
 	return 0;
 }
+#endif
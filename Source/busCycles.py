@@ -0,0 +1,591 @@
+#!/usr/bin/env python3
+#
+#       ______/  _____/  _____/     /   _/    /             /
+#     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+#      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+#         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+#  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+#
+#  busCycles.py
+#
+#  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl
+#  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+#
+# cycle counts of handleBus() from the assembly output of the firmware build (-save-temps, SKpico.s or
+# SKpico.c.s in the build directory): the WAIT_FOR_*_HALF_CYCLE macros leave a "busPath VIC|CPU <line>"
+# comment (BUS_PATH_MARK in SKpico.c), and from each such point the script follows the control flow to
+# the next ones. For each pair it reports
+#   - the shortest path, i.e. the half-cycle with no work to do (no SID access, no pending data lines/pot
+#     direction, no sample tick, no reset), and
+#   - the worst case over all paths, which has to fit into half a C64 cycle (the budget): otherwise the
+#     next PHI2 edge is detected late, and data is put on or released from the bus too late.
+# Paths leading to a "SLOW" mark (flash writes, reconfiguration in config mode) are not checked. A "DATA"
+# mark (after SET_DATA of a SID register read) does not end a path, the worst case from the half-cycle mark
+# up to it is reported separately: the time until the data is on the bus, not checked against a budget. Loops
+# other than the polling in WAIT_FOR_* and the inline delays, and calls of functions whose cost is not
+# known, make a path unbounded. The exit code is non-zero when a path is unbounded or over the budget.
+#
+# usage: busCycles.py [-v] [--mhz MHz] [--budget-ns ns] [--delay NAME=count]... SKpico.s|build directory
+#
+# the system clock defaults to SET_CLOCK_FAST (read from SKpico.c), the budget to half an NTSC cycle (the
+# shorter one). Delay loops (DELAY_Nx3p2_CYCLES) count as many iterations as their argument: numbers are
+# taken as they are, the bus timings default to the largest values of the timing presets (--delay to
+# change them). -v lists the instructions of each path.
+#
+# the cycle counts are a static model of the core named in the assembly (.cpu): Cortex-M0+ (RP2040) or
+# Cortex-M33 (RP2350), per instruction as in the technical reference manuals, without bus contention.
+#
+
+import argparse
+import glob
+import heapq
+import os
+import re
+import sys
+
+CONDITIONS = { 'eq', 'ne', 'cs', 'hs', 'cc', 'lo', 'mi', 'pl', 'vs', 'vc', 'hi', 'ls', 'ge', 'lt', 'gt', 'le' }
+
+LOADS  = { 'ldr', 'ldrb', 'ldrh', 'ldrsb', 'ldrsh', 'ldrd', 'ldrex', 'ldrexb', 'ldrexh' }
+STORES = { 'str', 'strb', 'strh', 'strd', 'strex', 'strexb', 'strexh' }
+
+# run-time library helpers which may be called from handleBus(): ( best, worst ) including call and return
+HELPERS = {
+	'__aeabi_uidiv':    ( 20, 40 ),
+	'__aeabi_uidivmod': ( 20, 40 ),
+	'__aeabi_idiv':     ( 22, 44 ),
+	'__aeabi_idivmod':  ( 22, 44 ),
+}
+
+# largest values of the bus timing presets (busTimings in SKpico.c)
+DEFAULT_DELAYS = { 'DELAY_PHI2_local': 15, 'DELAY_READ_BUS_local': 11 }
+
+C64_CLOCK_NTSC = 1022727
+
+re_marker  = re.compile( r'@\s*busPath\s+(\w+)\s+(\d+)' )
+re_label   = re.compile( r'^\s*([.\w$]+):(.*)$' )
+re_cpu     = re.compile( r'^\s*\.cpu\s+(\S+)' )
+re_table   = re.compile( r'^\s*\.(byte|2byte|short|hword|word)\s+\(?\s*([.\w$]+)' )
+re_srcline = re.compile( r'@\s*([^\s:]+\.c):(\d+):' )
+re_asmline = re.compile( r'^\s*@\s*(\d+)\s+"([^"]+)"\s+1\s*$' )
+re_asmend  = re.compile( r'^\s*@\s*0\s+""\s+2\s*$' )
+re_delay   = re.compile( r'DELAY_Nx3p2_CYCLES\s*\(\s*([^)]+?)\s*\)' )
+
+
+class Insn:
+	def __init__( self, line, mnemonic, operands, text ):
+		self.line = line			# line in the assembly file
+		self.mnemonic = mnemonic
+		self.operands = operands
+		self.text = text
+		self.marker = None			# ( kind, source line ) for BUS_PATH_MARK
+		self.table = []				# jump table targets (labels)
+		self.src = 0				# source line (-fverbose-asm comments, inline asm)
+		self.inlineAsm = 0			# source line of the asm statement the instruction comes from
+
+
+class Edge:
+	def __init__( self, to, taken, best, worst, note = None ):
+		self.to = to				# index, None = leaves the function
+		self.taken = taken
+		self.best = best
+		self.worst = worst
+		self.note = note			# reason why paths over this edge are unbounded
+
+
+def baseMnemonic( m ):
+	m = m.lower()
+	for suffix in ( '.n', '.w' ):
+		if m.endswith( suffix ):
+			m = m[ : -2 ]
+	return m
+
+
+def isCondBranch( m ):
+	return len( m ) == 3 and m[ 0 ] == 'b' and m[ 1 : ] in CONDITIONS
+
+
+def registerCount( operands ):
+	regs = re.search( r'\{([^}]*)\}', operands )
+	if not regs:
+		return 1
+	n = 0
+	for r in regs.group( 1 ).split( ',' ):
+		lo, _, hi = r.strip().partition( '-' )
+		if hi and lo[ 1 : ].isdigit() and hi[ 1 : ].isdigit():
+			n += int( hi[ 1 : ] ) - int( lo[ 1 : ] ) + 1
+		elif lo:
+			n += 1
+	return n
+
+
+def cycles( cpu, insn, taken ):
+	# returns ( best, worst ) for executing insn, with taken = the branch is taken
+	m = baseMnemonic( insn.mnemonic )
+	ops = insn.operands.lower()
+	m33 = cpu == 'm33'
+
+	if insn.marker:
+		return ( 0, 0 )
+	if m == 'b' or isCondBranch( m ) or m in ( 'cbz', 'cbnz' ):
+		if not taken:
+			return ( 1, 1 )
+		return ( 2, 3 ) if m33 else ( 2, 2 )
+	if m == 'bl':
+		target = insn.operands.strip()
+		if target.startswith( '__gnu_thumb1_case' ):
+			return ( 12, 12 )		# table lookup helper of switch statements on the M0+
+		if target in HELPERS:
+			return HELPERS[ target ]
+		return ( 2, 3 ) if m33 else ( 3, 3 )
+	if m in ( 'bx', 'blx' ):
+		return ( 2, 3 )
+	if m in ( 'tbb', 'tbh' ):
+		return ( 3, 4 )
+	if m in ( 'push', 'pop', 'ldm', 'ldmia', 'ldmfd', 'stm', 'stmia', 'stmea', 'stmdb' ):
+		n = registerCount( insn.operands )
+		extra = 3 if m == 'pop' and 'pc' in ops else 0
+		return ( 1 + n + extra, 1 + n + extra )
+	if m in LOADS:
+		if 'pc' in ops.split( ',' )[ 0 ]:
+			return ( 4, 5 )
+		return ( 1, 2 ) if m33 else ( 2, 2 )
+	if m in STORES:
+		return ( 1, 1 ) if m33 else ( 2, 2 )
+	if m in ( 'udiv', 'sdiv' ):
+		return ( 2, 11 )
+	if m in ( 'dmb', 'dsb', 'isb' ):
+		return ( 3, 4 )
+	return ( 1, 1 )
+
+
+def parse( path, function ):
+	cpu = 'm0plus'
+	source = None
+	insns = []
+	labels = {}				# label -> index of the next instruction
+	numeric = []			# ( number, index ) of numeric local labels, in order
+	inside = False
+	lastTableOwner = None
+	src = 0
+	inlineAsm = 0
+
+	with open( path, encoding = 'latin-1' ) as f:
+		lines = f.readlines()
+
+	for nr, raw in enumerate( lines, 1 ):
+		m = re_cpu.match( raw )
+		if m and 'm33' in m.group( 1 ):
+			cpu = 'm33'
+
+		line = raw.rstrip( '\n' )
+		if not inside:
+			if re.match( r'^' + re.escape( function ) + r':', line ):
+				inside = True
+			continue
+		if re.match( r'^\s*\.size\s+' + re.escape( function ) + r'\s*,', line ):
+			break
+
+		mk = re_marker.search( line )
+		if mk:
+			ins = Insn( nr, '', '', line.strip() )
+			ins.marker = ( mk.group( 1 ), int( mk.group( 2 ) ) )
+			ins.src = ins.marker[ 1 ]
+			insns.append( ins )
+			continue
+
+		# inline asm is enclosed in '@ <line> "<file>" 1' and '@ 0 "" 2'
+		am = re_asmline.match( line )
+		if am:
+			inlineAsm = int( am.group( 1 ) )
+			if source is None:
+				source = am.group( 2 )
+			continue
+		if re_asmend.match( line ):
+			inlineAsm = 0
+			continue
+
+		sm = re_srcline.search( line )
+		if sm:
+			src = int( sm.group( 2 ) )
+
+		code = line.split( '@', 1 )[ 0 ]
+		while True:
+			lm = re_label.match( code )
+			if not lm:
+				break
+			name = lm.group( 1 )
+			if name.isdigit():
+				numeric.append( ( name, len( insns ) ) )
+			else:
+				labels[ name ] = len( insns )
+			code = lm.group( 2 )
+
+		code = code.strip()
+		if not code:
+			continue
+
+		if code.startswith( '.' ):
+			t = re_table.match( code )
+			if t and lastTableOwner is not None:
+				insns[ lastTableOwner ].table.append( t.group( 2 ) )
+			continue
+
+		parts = code.split( None, 1 )
+		ins = Insn( nr, parts[ 0 ], parts[ 1 ] if len( parts ) > 1 else '', code )
+		ins.src = inlineAsm or src
+		ins.inlineAsm = inlineAsm
+		insns.append( ins )
+
+		mn = baseMnemonic( ins.mnemonic )
+		if ( mn == 'bl' and ins.operands.startswith( '__gnu_thumb1_case' ) ) or mn in ( 'tbb', 'tbh' ):
+			lastTableOwner = len( insns ) - 1
+		else:
+			lastTableOwner = None
+
+	if not inside:
+		sys.exit( 'busCycles: function %s not found in %s' % ( function, path ) )
+
+	return cpu, source, insns, labels, numeric
+
+
+def resolve( target, index, labels, numeric ):
+	target = target.strip()
+	lm = re.match( r'^(\d+)([bf])$', target )
+	if lm:
+		if lm.group( 2 ) == 'b':
+			c = [ i for n, i in numeric if n == lm.group( 1 ) and i <= index ]
+			return c[ -1 ] if c else None
+		c = [ i for n, i in numeric if n == lm.group( 1 ) and i > index ]
+		return c[ 0 ] if c else None
+	return labels.get( target )
+
+
+def delayCount( ins, sourceLines, delays ):
+	d = re_delay.search( sourceLines.get( ins.inlineAsm, '' ) )
+	if not d:
+		return None
+	arg = d.group( 1 )
+	if re.match( r'^(0x[0-9a-fA-F]+|\d+)$', arg ):
+		return int( arg, 0 )
+	return delays.get( arg )
+
+
+def buildGraph( cpu, insns, labels, numeric, sourceLines, delays ):
+	# edges of each instruction. The polling of WAIT_FOR_* (branching back instead of falling through to
+	# the mark) is left out, and a delay loop becomes a single edge with the cost of all its iterations
+	graph = []
+	for i, ins in enumerate( insns ):
+		nxt = i + 1 if i + 1 < len( insns ) else None
+		if ins.marker:
+			graph.append( [ Edge( nxt, False, 0, 0 ) ] )
+			continue
+
+		m = baseMnemonic( ins.mnemonic )
+		ops = ins.operands
+		cn = cycles( cpu, ins, False )
+		ct = cycles( cpu, ins, True )
+		edges = []
+
+		if m == 'b':
+			edges.append( Edge( resolve( ops, i, labels, numeric ), True, *ct ) )
+		elif isCondBranch( m ) or m in ( 'cbz', 'cbnz' ):
+			target = resolve( ops.split( ',' )[ -1 ], i, labels, numeric )
+			if nxt is not None and insns[ nxt ].marker and insns[ nxt ].marker[ 0 ] in ( 'VIC', 'CPU' ):
+				# polling of WAIT_FOR_*: only the last test, which falls through, belongs to the path
+				edges.append( Edge( nxt, False, *cn ) )
+			elif ins.inlineAsm and target is not None and target <= i:
+				# DELAY_Nx3p2_CYCLES: the first pass falls through, each further one repeats the loop body
+				count = delayCount( ins, sourceLines, delays )
+				if count is None:
+					edges.append( Edge( nxt, False, *cn, note = 'loop of unknown count at line %d (--delay?)' % ins.src ) )
+				else:
+					body = [ cycles( cpu, insns[ k ], False ) for k in range( target, i ) ]
+					extra = max( count - 1, 0 )
+					edges.append( Edge( nxt, False,
+						cn[ 0 ] + extra * ( sum( b for b, w in body ) + ct[ 0 ] ),
+						cn[ 1 ] + extra * ( sum( w for b, w in body ) + ct[ 1 ] ) ) )
+			else:
+				edges.append( Edge( nxt, False, *cn ) )
+				edges.append( Edge( target, True, *ct ) )
+		elif ( m == 'bl' and ops.startswith( '__gnu_thumb1_case' ) ) or m in ( 'tbb', 'tbh' ):
+			for t in ins.table:
+				edges.append( Edge( resolve( t, i, labels, numeric ), True, *ct ) )
+		elif m in ( 'bl', 'blx' ):
+			target = ops.strip()
+			note = None if m == 'bl' and target in HELPERS else 'call of %s at line %d' % ( target, ins.src )
+			edges.append( Edge( nxt, False, *cn, note = note ) )
+		elif m == 'bx' or ( m == 'pop' and 'pc' in ops ) or ( ops.split( ',' )[ 0 ].strip() == 'pc' ):
+			edges.append( Edge( None, True, *ct ) )
+		else:
+			edges.append( Edge( nxt, False, *cn ) )
+
+		for e in edges:
+			if e.to is None and e.taken and m != 'bx' and m != 'pop':
+				e.note = 'branch target of asm line %d not found' % ins.line
+		graph.append( edges )
+	return graph
+
+
+def isStop( ins ):
+	# marks which start and end the half-cycle paths ("DATA" marks are passed through)
+	return ins.marker is not None and ins.marker[ 0 ] != 'DATA'
+
+
+def shortestPaths( insns, graph, start ):
+	# Dijkstra from the mark 'start' to every mark reachable without passing another one
+	dist = { start: 0 }
+	prev = {}
+	heap = [ ( 0, start ) ]
+	ends = {}
+
+	while heap:
+		d, i = heapq.heappop( heap )
+		if d > dist.get( i, 1 << 60 ):
+			continue
+		if i != start and isStop( insns[ i ] ):
+			ends[ i ] = d
+			continue
+		for e in graph[ i ]:
+			if e.to is None:
+				continue
+			if d + e.worst < dist.get( e.to, 1 << 60 ):
+				dist[ e.to ] = d + e.worst
+				prev[ e.to ] = ( i, e )
+				heapq.heappush( heap, ( d + e.worst, e.to ) )
+
+	paths = {}
+	for end in ends:
+		path = []
+		j = end
+		while j != start:
+			i, e = prev[ j ]
+			path.append( ( i, e ) )
+			j = i
+		paths[ end ] = list( reversed( path ) )
+	return paths
+
+
+class LongestPaths:
+	# longest path from an instruction to the mark 'end' without passing other marks (memoized):
+	# None = 'end' is not reachable, a string = unbounded (the reason), otherwise ( worst, best, edge )
+	def __init__( self, insns, graph, end ):
+		self.insns = insns
+		self.graph = graph
+		self.end = end
+		self.memo = {}
+		self.active = set()
+		self.reach = self.reaching()
+
+	def reaching( self ):
+		# instructions from which 'end' can be reached (backwards search stopping at other marks)
+		pred = {}
+		for i, edges in enumerate( self.graph ):
+			for e in edges:
+				if e.to is not None:
+					pred.setdefault( e.to, [] ).append( i )
+		reach = { self.end }
+		todo = [ self.end ]
+		while todo:
+			j = todo.pop()
+			for i in pred.get( j, [] ):
+				if i not in reach:
+					reach.add( i )
+					if not isStop( self.insns[ i ] ):
+						todo.append( i )
+		return reach
+
+	def viaEdge( self, e ):
+		if e.to is None:
+			return e.note
+		if e.to not in self.reach:
+			return None
+		r = self.fromInsn( e.to )
+		if isinstance( r, tuple ):
+			if e.note:
+				return e.note
+			return ( r[ 0 ] + e.worst, r[ 1 ] + e.best, e )
+		return r
+
+	def longest( self, edges ):
+		result = None
+		for e in edges:
+			r = self.viaEdge( e )
+			if isinstance( r, str ):
+				return r
+			if r is not None and ( result is None or r[ 0 ] > result[ 0 ] ):
+				result = r
+		return result
+
+	def fromInsn( self, i ):
+		if i == self.end:
+			return ( 0, 0, None )
+		if isStop( self.insns[ i ] ):
+			return None
+		if i in self.memo:
+			return self.memo[ i ]
+		if i in self.active:
+			return 'loop at line %d' % self.insns[ i ].src
+
+		self.active.add( i )
+		self.memo[ i ] = self.longest( self.graph[ i ] )
+		self.active.discard( i )
+		return self.memo[ i ]
+
+	def fromMark( self, start ):
+		return self.longest( self.graph[ start ] )
+
+	def path( self, start ):
+		path = []
+		r = self.fromMark( start )
+		i = start
+		while r[ 2 ] is not None:
+			path.append( ( i, r[ 2 ] ) )
+			i = r[ 2 ].to
+			r = self.fromInsn( i )
+		return path
+
+
+def describe( ins ):
+	return '%s %d' % ins.marker
+
+
+def listPath( insns, path ):
+	for i, e in path:
+		ins = insns[ i ]
+		if ins.marker:
+			continue
+		taken = '   (taken)' if e.taken and baseMnemonic( ins.mnemonic ) != 'b' else ''
+		print( '      %6d  %5d  %3d..%-4d %s%s' % ( ins.line, ins.src, e.best, e.worst, ins.text, taken ) )
+	print()
+
+
+def main():
+	ap = argparse.ArgumentParser( description = 'cycle counts of the handleBus() half-cycle paths' )
+	ap.add_argument( 'asm', help = 'assembly output of SKpico.c (-save-temps), or the build directory' )
+	ap.add_argument( '--function', default = 'handleBus' )
+	ap.add_argument( '--source', help = 'SKpico.c (default: as named in the assembly, or next to this script)' )
+	ap.add_argument( '--mhz', type = float, help = 'system clock (default: SET_CLOCK_FAST)' )
+	ap.add_argument( '--budget-ns', type = float, default = 1e9 / C64_CLOCK_NTSC / 2, help = 'time per half-cycle path (default: half an NTSC cycle)' )
+	ap.add_argument( '--delay', action = 'append', default = [], metavar = 'NAME=COUNT', help = 'iterations of DELAY_Nx3p2_CYCLES( NAME )' )
+	ap.add_argument( '-v', action = 'store_true', help = 'list the instructions of each path' )
+	args = ap.parse_args()
+
+	if os.path.isdir( args.asm ):
+		found = glob.glob( os.path.join( args.asm, '**', 'SKpico*.s' ), recursive = True )
+		if not found:
+			sys.exit( 'busCycles: no SKpico*.s in %s (built with -save-temps?)' % args.asm )
+		args.asm = max( found, key = os.path.getmtime )
+
+	cpu, source, insns, labels, numeric = parse( args.asm, args.function )
+	markers = [ i for i, ins in enumerate( insns ) if ins.marker ]
+	if not markers:
+		sys.exit( 'busCycles: no busPath marks in %s (built without BUS_PATH_MARK?)' % args.asm )
+
+	if args.source:
+		source = args.source
+	if source is None or not os.path.exists( source ):
+		source = os.path.join( os.path.dirname( os.path.abspath( __file__ ) ), 'SKpico.c' )
+	sourceLines = {}
+	if os.path.exists( source ):
+		with open( source, encoding = 'latin-1' ) as f:
+			sourceLines = { n: l for n, l in enumerate( f, 1 ) }
+
+	mhz = args.mhz
+	if mhz is None:
+		mhz = 300.0
+		for l in sourceLines.values():
+			pll = re.search( r'define\s+SET_CLOCK_FAST\s+set_sys_clock_pll\(\s*(\d+)\s*,\s*(\d+)\s*,\s*(\d+)\s*\)', l )
+			if pll:
+				mhz = int( pll.group( 1 ) ) / int( pll.group( 2 ) ) / int( pll.group( 3 ) ) / 1e6
+	budget = int( args.budget_ns * mhz / 1000.0 )
+
+	delays = dict( DEFAULT_DELAYS )
+	for d in args.delay:
+		name, _, value = d.partition( '=' )
+		delays[ name.strip() ] = int( value, 0 )
+
+	graph = buildGraph( cpu, insns, labels, numeric, sourceLines, delays )
+
+	print( '%s: %s, %d instructions, %.0f MHz, budget %d cycles (%.1f ns) per half-cycle path' % ( args.function, 'Cortex-M33 (RP2350)' if cpu == 'm33' else 'Cortex-M0+ (RP2040)', len( insns ) - len( markers ), mhz, budget, args.budget_ns ) )
+	print( 'delay loops: ' + ', '.join( '%s = %d' % kv for kv in sorted( delays.items() ) ) )
+	print()
+	print( '%-24s  %7s  %7s  %8s  %s' % ( 'path', 'no work', 'worst', 'worst ns', '' ) )
+
+	longest = {}
+	failed = 0
+	starts = [ s for s in markers if insns[ s ].marker[ 0 ] in ( 'VIC', 'CPU' ) ]
+	for s in starts:
+		shortest = shortestPaths( insns, graph, s )
+		for end in sorted( shortest, key = lambda e: insns[ e ].line ):
+			name = describe( insns[ s ] ) + ' -> ' + describe( insns[ end ] )
+			idle = sum( e.worst for i, e in shortest[ end ] )
+			if insns[ end ].marker[ 0 ] == 'SLOW':
+				print( '%-24s  %7d  %7s  %8s  not checked' % ( name, idle, '-', '-' ) )
+				continue
+
+			if end not in longest:
+				longest[ end ] = LongestPaths( insns, graph, end )
+			r = longest[ end ].fromMark( s )
+			if isinstance( r, str ):
+				failed += 1
+				print( '%-24s  %7d  %7s  %8s  FAILED: unbounded, %s' % ( name, idle, '-', '-', r ) )
+			else:
+				status = 'ok'
+				if r[ 0 ] > budget:
+					failed += 1
+					status = 'FAILED: %d cycles over budget' % ( r[ 0 ] - budget )
+				print( '%-24s  %7d  %7d  %8.1f  %s' % ( name, idle, r[ 0 ], r[ 0 ] * 1000.0 / mhz, status ) )
+
+			if args.v:
+				print( '    no work:' )
+				listPath( insns, shortest[ end ] )
+				if not isinstance( r, str ):
+					print( '    worst case:' )
+					listPath( insns, longest[ end ].path( s ) )
+
+	# time until the data of a read is on the bus
+	dataMarks = [ d for d in markers if insns[ d ].marker[ 0 ] == 'DATA' ]
+	if dataMarks:
+		print()
+		print( '%-24s  %7s  %7s  %8s  %s' % ( 'up to the data', '', 'worst', 'worst ns', '' ) )
+	for d in dataMarks:
+		toData = LongestPaths( insns, graph, d )
+		for s in starts:
+			r = toData.fromMark( s )
+			if r is None:
+				continue
+			name = describe( insns[ s ] ) + ' -> ' + describe( insns[ d ] )
+			if isinstance( r, str ):
+				failed += 1
+				print( '%-24s  %7s  %7s  %8s  FAILED: unbounded, %s' % ( name, '', '-', '-', r ) )
+				continue
+			print( '%-24s  %7s  %7d  %8.1f' % ( name, '', r[ 0 ], r[ 0 ] * 1000.0 / mhz ) )
+			if args.v:
+				print( '    worst case:' )
+				listPath( insns, toData.path( s ) )
+
+	print()
+	if failed:
+		print( 'busCycles: %d path(s) FAILED' % failed )
+		sys.exit( 1 )
+	print( 'busCycles: all paths within the budget' )
+
+
+if __name__ == '__main__':
+	sys.setrecursionlimit( 100000 )
+	main()
@@ -0,0 +1,185 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  busRing.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// ring buffer between handleBus() (producer) and the emulation core (consumer) holding SID/FM-commands.
+// Each entry is 32 bits: the command ( A << 8 ) | D (bit 15: SID2/FM) in the lower half, and the number 
+// of C64 cycles since the previous entry in the upper half. If this delta does not fit into 16 bits 
+// (and after a reset), a sync entry with the absolute time stamp (lower 30 bits) is inserted; the consumer 
+// reconstructs the full (wrapping 32-bit) time stamp from c64CycleCounter.
+//
+// a full ring drops the new command (counted in ringOverflows), ringHighWater is the maximum fill level 
+//
+// producer and consumer run on different cores (single producer, single consumer): each index is 
+// written by one side only. The producer writes entries, then advances ringWrite with release semantics; 
+// the consumer reads ringWrite with acquire semantics before reading entries, and hands slots back the 
+// same way via ringRead. The consumer works in batches (ringBeginBatch/ringEndBatch, ringPopBatch), 
+// i.e. with one acquire and one release per batch instead of per entry. To discard pending entries 
+// (reset) the producer calls ringFlush(), which the consumer applies with its next batch.
+//
+
+#ifndef _BUSRING_H_
+#define _BUSRING_H_
+
+#define RING_SIZE		1024
+#define RING_MASK		( RING_SIZE - 1 )
+#define RING_SYNC		( 1 << 14 )			// free bit in the command: A is 5 bits
+
+uint32_t ringBuf[ RING_SIZE ];
+volatile uint16_t ringWrite = 0;			// written by the producer only
+volatile uint16_t ringRead  = 0;			// written by the consumer only
+
+volatile uint16_t ringFlushAt = 0;			// producer: entries before this index are discarded ...
+volatile uint8_t  ringFlushReq = 0;			// ... when this differs from the consumer's ringFlushAck
+uint8_t  ringFlushAck = 0;
+
+uint32_t ringLastTime = 0;					// producer: time stamp of the last entry
+uint8_t  ringNeedSync = 1;
+uint32_t ringReadTime = 0;					// consumer: time stamp of the last consumed entry
+uint8_t  ringCommandsRead = 0;				// consumer: commands (no sync entries) consumed since the last flush, mod 256
+
+volatile uint32_t ringHighWater = 0;
+volatile uint32_t ringOverflows = 0;
+
+#define RING_NEXT( i )			( ( (i) + 1 ) & RING_MASK )
+
+// the index (and flush request) of the other side: acquire on reading, release on writing one's own
+#define RING_LOAD_ACQUIRE( v )		__atomic_load_n( &(v), __ATOMIC_ACQUIRE )
+#define RING_STORE_RELEASE( v, x )	__atomic_store_n( &(v), (x), __ATOMIC_RELEASE )
+
+#define RING_IS_SYNC( e )		( (e) & RING_SYNC )
+#define RING_CMD( e )			( (uint16_t)(e) )
+#define RING_DELTA( e )			( (e) >> 16 )
+
+__attribute__((always_inline)) static inline void ringPush( uint16_t cmd, uint32_t time )
+{
+	uint32_t delta = time - ringLastTime;
+	uint16_t wr = ringWrite;
+	uint32_t fill = ( wr - RING_LOAD_ACQUIRE( ringRead ) ) & RING_MASK;
+
+	if ( delta > 0xffff || ringNeedSync )
+	{
+		if ( fill >= RING_SIZE - 2 )
+		{
+			ringOverflows ++;
+			return;
+		}
+		ringBuf[ wr ] = RING_SYNC | ( ( time >> 16 ) & 0x3fff ) | ( time << 16 );
+		wr = RING_NEXT( wr );
+		ringNeedSync = 0;
+		delta = 0;
+		fill ++;
+	} else
+	if ( fill >= RING_SIZE - 1 )
+	{
+		ringOverflows ++;
+		return;
+	}
+
+	ringLastTime = time;
+	ringBuf[ wr ] = cmd | ( delta << 16 );
+
+	// publishes the command (and the sync entry)
+	RING_STORE_RELEASE( ringWrite, RING_NEXT( wr ) );
+
+	if ( ++ fill > ringHighWater )
+		ringHighWater = fill;
+}
+
+// producer: discards all entries pushed so far (reset), the next entry carries the absolute time stamp
+__attribute__((always_inline)) static inline void ringFlush()
+{
+	__atomic_store_n( &ringFlushAt, ringWrite, __ATOMIC_RELAXED );	// may be read during a flush by the consumer
+	RING_STORE_RELEASE( ringFlushReq, (uint8_t)( ringFlushReq + 1 ) );
+	ringNeedSync = 1;
+}
+
+// both sides idle (initialization): empty ring
+static inline void ringInit()
+{
+	ringRead = ringWrite = ringFlushAt = 0;
+	ringCommandsRead = 0;
+	ringFlushAck = ringFlushReq;
+	ringNeedSync = 1;
+}
+
+//
+// consumer: a batch covers the entries published when it begins, read advances over the consumed ones
+//
+typedef struct
+{
+	uint16_t read, end;
+} RING_BATCH;
+
+__attribute__((always_inline)) static inline void ringBeginBatch( RING_BATCH *b )
+{
+	b->read = ringRead;
+
+	uint8_t req = RING_LOAD_ACQUIRE( ringFlushReq );
+	uint16_t flushAt = __atomic_load_n( &ringFlushAt, __ATOMIC_RELAXED );
+	b->end = RING_LOAD_ACQUIRE( ringWrite );
+
+	if ( req != ringFlushAck )
+	{
+		ringFlushAck = req;
+		// a newer flush may have been read together with an older request: never step back
+		if ( ( ( flushAt - b->read ) & RING_MASK ) <= ( ( b->end - b->read ) & RING_MASK ) )
+			b->read = flushAt;
+		ringCommandsRead = 0;
+	}
+}
+
+// hands the consumed slots back to the producer
+__attribute__((always_inline)) static inline void ringEndBatch( RING_BATCH *b )
+{
+	RING_STORE_RELEASE( ringRead, b->read );
+}
+
+// copies (at most n) entries and consumes them, returns the number of entries
+static inline uint32_t ringPopBatch( uint32_t *dst, uint32_t n )
+{
+	RING_BATCH b;
+	uint32_t i = 0;
+
+	ringBeginBatch( &b );
+	while ( i < n && b.read != b.end )
+	{
+		dst[ i ++ ] = ringBuf[ b.read ];
+		b.read = RING_NEXT( b.read );
+	}
+	ringEndBatch( &b );
+
+	return i;
+}
+
+// consumer: absolute time of a sync entry, the time stamp is at most 2^30 cycles in the past
+__attribute__((always_inline)) static inline uint32_t ringSyncTime( uint32_t e, uint32_t now )
+{
+	uint32_t t30 = ( ( e & 0x3fff ) << 16 ) | RING_DELTA( e );
+	return now - ( ( now - t30 ) & 0x3fffffff );
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  busTrace.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// compact binary format for recording what the C64 does on the bus (SID/FM register 
+// writes and reads with cycle-exact timing), used for deterministic replay on the host
+//
+// a trace is a BUSTRACE_HEADER followed by 4-byte events (all little endian):
+//   byte 0:    bits 7..5 event kind (BT_*), bits 4..0 register (as seen by handleBus, A0..A4)
+//   byte 1:    value written (or read)
+//   byte 2..3: number of C64 cycles since the previous event
+// if the delta does not fit into 16 bits, BT_DELTA-events precede the event and advance 
+// the time without any bus access (29 bit delta: bits 15..0 in bytes 2..3, bits 20..16 in 
+// the register field, bits 28..21 in byte 1)
+//
+// FM (OPL) accesses use register 0x00 for the address port and 0x10 for the data port
+//
+
+#ifndef _BUSTRACE_H_
+#define _BUSTRACE_H_
+
+#include <stdint.h>
+
+#define BUSTRACE_MAGIC		0x52544b53		// "SKTR"
+#define BUSTRACE_VERSION	1
+
+#define BT_WRITE_SID1		0
+#define BT_WRITE_SID2		1
+#define BT_WRITE_FM			2
+#define BT_READ_SID1		3
+#define BT_READ_SID2		4
+#define BT_READ_FM			5
+#define BT_DELTA			7
+
+#define BUSTRACE_MAX_DELTA16	0xffff
+#define BUSTRACE_MAX_DELTA29	0x1fffffff
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t headerSize;	// sizeof( BUSTRACE_HEADER ), events start right after the header
+	uint32_t c64Clock;		// clock of the recorded machine (PAL/NTSC)
+	uint32_t nEvents;		// including BT_DELTA-events
+	uint8_t  config[ 64 ];	// SKpico configuration at the time of recording
+} BUSTRACE_HEADER;
+
+typedef struct
+{
+	uint8_t  kindReg;
+	uint8_t  value;
+	uint16_t delta;
+} BUSTRACE_EVENT;
+
+#define BUSTRACE_KIND( e )	( (e).kindReg >> 5 )
+#define BUSTRACE_REG( e )	( (e).kindReg & 0x1f )
+
+static inline BUSTRACE_EVENT busTraceEvent( uint8_t kind, uint8_t reg, uint8_t value, uint16_t delta )
+{
+	BUSTRACE_EVENT e = { (uint8_t)( ( kind << 5 ) | ( reg & 0x1f ) ), value, delta };
+	return e;
+}
+
+static inline BUSTRACE_EVENT busTraceDeltaEvent( uint32_t delta )
+{
+	BUSTRACE_EVENT e = { (uint8_t)( ( BT_DELTA << 5 ) | ( ( delta >> 16 ) & 0x1f ) ), (uint8_t)( delta >> 21 ), (uint16_t)delta };
+	return e;
+}
+
+static inline uint32_t busTraceDelta( BUSTRACE_EVENT e )
+{
+	if ( BUSTRACE_KIND( e ) == BT_DELTA )
+		return (uint32_t)e.delta | ( (uint32_t)BUSTRACE_REG( e ) << 16 ) | ( (uint32_t)e.value << 21 );
+	return e.delta;
+}
+
+#endif
@@ -0,0 +1,192 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  emuProfile.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// optional cycle-budget instrumentation of the emulation loop (#define EMU_PROFILING in SKpico.c):
+// each phase of runEmulation() is timed (SysTick, i.e. CPU clock cycles), min/avg/max and a histogram 
+// are kept per phase, and the emulation core counts late samples (i.e. rendered after the following
+// sample tick, see sampleFifo.h). 
+//
+// the statistics are exported as a byte stream which the C64 reads in config mode: select the last 
+// byte of the VERSION_STR window ($d41e = 255) and then read $d41d repeatedly. Selecting starts a new 
+// measurement interval, the export is refreshed every EMU_PROFILE_EXPORT_INTERVAL samples.
+//
+// export layout (multi-byte values little endian):
+//   u8  version (0 = profiling not available, VERSION_STR[ 31 ] in regular builds)
+//   u8  number of phases, u8 number of histogram bins, u8 log2 of the first bin's upper bound
+//   u32 timer ticks per output sample (the budget)
+//   u32 samples, u32 late samples
+//   u32 ring buffer high-water mark, u32 ring buffer overflows (busRing.h, since boot)
+//   u32 sample FIFO underruns, u32 sample FIFO overflows (sampleFifo.h, since boot)
+//   per phase: u32 min, u32 avg, u32 max, u16 histogram[ bins ] (saturating)
+//
+
+#ifndef _EMUPROFILE_H_
+#define _EMUPROFILE_H_
+
+#ifdef EMU_PROFILING
+
+typedef enum {
+	PROF_DRAIN = 0,		// ring buffer drain including digi-detection
+	PROF_EMULATE,		// emulateCyclesReSID(Single)
+	PROF_READREGS,		// readRegs
+	PROF_VOICE3,		// OSC3/ENV3 lookahead (voice3Ahead.h), while the C64 polls them
+	PROF_FM,			// ym3812_update_one
+	PROF_MIX,			// outputReSID(FM)
+	PROF_AUDIO_OUT,		// I2S buffer handoff
+	PROF_LED,			// RGB LED computation
+	PROF_BUSY,			// all of the above, summed over one sample period
+	PROF_PHASES
+} PROF_PHASE;
+
+#define PROF_HIST_BINS		12
+#define PROF_HIST_SHIFT		4		// bin 0: < 2^5 ticks, bin i: [ 2^(i+4), 2^(i+5) ), last bin: everything above
+
+#define EMU_PROFILE_VERSION				3
+#define EMU_PROFILE_EXPORT_INTERVAL		256
+#define EMU_PROFILE_EXPORT_SIZE			( 32 + PROF_PHASES * ( 12 + 2 * PROF_HIST_BINS ) )
+
+typedef struct
+{
+	uint32_t minT, maxT, count;
+	uint64_t sumT;
+	uint16_t hist[ PROF_HIST_BINS ];
+} PROF_STATS;
+
+PROF_STATS	emuProfile[ PROF_PHASES ];
+uint32_t	emuProfileBusy, emuProfileSamples;
+uint32_t	emuProfileLateStart;						// sampleFifoLate at the start of the interval
+volatile uint8_t  emuProfileRestart = 1;					// set by handleBus() when the window is selected
+uint8_t		emuProfileExport[ EMU_PROFILE_EXPORT_SIZE ];
+
+#ifdef SKPICO_HOST
+#include <time.h>
+#define EMU_PROFILE_TICKS_PER_SAMPLE	( 1000000000 / AUDIO_RATE )
+__attribute__((always_inline)) static inline uint32_t emuProfileNow()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint32_t)( ts.tv_sec * 1000000000ull + ts.tv_nsec ) & 0x00ffffff;
+}
+#else
+#include "hardware/structs/systick.h"
+#define EMU_PROFILE_TICKS_PER_SAMPLE	( clock_get_hz( clk_sys ) / AUDIO_RATE )
+// SysTick counts down, 24 bits
+__attribute__((always_inline)) static inline uint32_t emuProfileNow()
+{
+	return 0x00ffffff - systick_hw->cvr;
+}
+#endif
+
+static void emuProfileInit()
+{
+	#ifndef SKPICO_HOST
+	systick_hw->rvr = 0x00ffffff;
+	systick_hw->cvr = 0;
+	systick_hw->csr = 0x5;		// enable, processor clock, no interrupt
+	#endif
+	emuProfileRestart = 1;
+}
+
+__attribute__((always_inline)) static inline void emuProfileRecord( PROF_PHASE phase, uint32_t t )
+{
+	PROF_STATS *p = &emuProfile[ phase ];
+	if ( t < p->minT ) p->minT = t;
+	if ( t > p->maxT ) p->maxT = t;
+	p->count ++;
+	p->sumT += t;
+
+	int bin = ( 31 - __builtin_clz( t | 1 ) ) - PROF_HIST_SHIFT;
+	if ( bin < 0 ) bin = 0;
+	if ( bin >= PROF_HIST_BINS ) bin = PROF_HIST_BINS - 1;
+	if ( p->hist[ bin ] < 0xffff ) p->hist[ bin ] ++;
+}
+
+#define EMU_PROFILE_START( t )		uint32_t t = emuProfileNow();
+#define EMU_PROFILE_END( phase, t )	{ uint32_t _t = ( emuProfileNow() - t ) & 0x00ffffff; emuProfileBusy += _t; emuProfileRecord( phase, _t ); }
+
+static void emuProfileWrite32( uint8_t *p, uint32_t v )
+{
+	p[ 0 ] = v; p[ 1 ] = v >> 8; p[ 2 ] = v >> 16; p[ 3 ] = v >> 24;
+}
+
+static void emuProfileExportStats()
+{
+	uint8_t *p = emuProfileExport;
+	*( p ++ ) = EMU_PROFILE_VERSION;
+	*( p ++ ) = PROF_PHASES;
+	*( p ++ ) = PROF_HIST_BINS;
+	*( p ++ ) = PROF_HIST_SHIFT + 1;
+	emuProfileWrite32( p, EMU_PROFILE_TICKS_PER_SAMPLE ); p += 4;
+	emuProfileWrite32( p, emuProfileSamples ); p += 4;
+	emuProfileWrite32( p, sampleFifoLate - emuProfileLateStart ); p += 4;
+	emuProfileWrite32( p, ringHighWater ); p += 4;
+	emuProfileWrite32( p, ringOverflows ); p += 4;
+	emuProfileWrite32( p, sampleFifoUnderruns ); p += 4;
+	emuProfileWrite32( p, sampleFifoOverflows ); p += 4;
+
+	for ( int i = 0; i < PROF_PHASES; i++ )
+	{
+		PROF_STATS *s = &emuProfile[ i ];
+		emuProfileWrite32( p, s->count ? s->minT : 0 ); p += 4;
+		emuProfileWrite32( p, s->count ? (uint32_t)( s->sumT / s->count ) : 0 ); p += 4;
+		emuProfileWrite32( p, s->maxT ); p += 4;
+		for ( int j = 0; j < PROF_HIST_BINS; j++ )
+		{
+			*( p ++ ) = s->hist[ j ];
+			*( p ++ ) = s->hist[ j ] >> 8;
+		}
+	}
+}
+
+// to be called after each output sample: records the busy time of the sample period, exports/restarts the statistics
+static void emuProfileSampleDone()
+{
+	emuProfileRecord( PROF_BUSY, emuProfileBusy );
+	emuProfileBusy = 0;
+
+	if ( ( ++ emuProfileSamples % EMU_PROFILE_EXPORT_INTERVAL ) == 0 )
+		emuProfileExportStats();
+
+	if ( emuProfileRestart )
+	{
+		memset( emuProfile, 0, sizeof( emuProfile ) );
+		for ( int i = 0; i < PROF_PHASES; i++ )
+			emuProfile[ i ].minT = 0xffffffff;
+		emuProfileSamples = 0;
+		emuProfileLateStart = sampleFifoLate;
+		emuProfileRestart = 0;
+	}
+}
+
+#else
+
+#define EMU_PROFILE_START( t )
+#define EMU_PROFILE_END( phase, t )
+
+#endif
+
+#endif
@@ -0,0 +1,488 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  emulationCore.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// the emulation side of the SID/FM pipeline: draining the ring buffer filled by handleBus(), 
+// digi-detection, clocking reSID and producing the next output sample. This is used by 
+// runEmulation() and by the host-side tools (trace replay) such that both run exactly the same code.
+//
+// all time stamps are 32-bit C64 cycle counts which wrap around, i.e. they must only be compared via 
+// their difference (see TIME_AFTER)
+//
+// the includer has to provide (as in SKpico.c): the ring buffer (busRing.h), c64CycleCounter, lastSIDEmulationCycle, outRegisters(_2), sidDACMode and hack_OPL_Sample_*
+//
+
+#ifndef _EMULATIONCORE_H_
+#define _EMULATIONCORE_H_
+
+#include "sampleFifo.h"
+#include "emuProfile.h"
+#include "voice3Ahead.h"
+
+// wrap-safe "time stamp a is later than b" for 32-bit cycle counts
+#define TIME_AFTER( a, b )	( (int32_t)( (uint32_t)(a) - (uint32_t)(b) ) > 0 )
+
+//
+// state of the digi-playing detection
+//
+
+typedef enum {
+	DD_IDLE = 0,
+	DD_PREP,
+	DD_CONF,
+	DD_PREP2,
+	DD_CONF2,
+	DD_SET,
+	DD_VAR1,
+	DD_VAR2
+} DD_STATE;
+
+DD_STATE ddTB_state[ 3 ] = { DD_IDLE, DD_IDLE, DD_IDLE };
+uint32_t ddTB_cycle[ 3 ] = { 0, 0, 0 };
+uint8_t  ddTB_sample[ 3 ] = { 0, 0, 0 };
+
+DD_STATE ddPWM_state[ 3 ] = { DD_IDLE, DD_IDLE, DD_IDLE };
+uint32_t ddPWM_cycle[ 3 ] = { 0, 0, 0 };
+uint8_t  ddPWM_sample[ 3 ] = { 0, 0, 0 };
+
+#define DD_TB_TIMEOUT0	135
+// def 22 and 12
+#define DD_TB_TIMEOUT	22
+#define DD_PWM_TIMEOUT	22
+
+uint8_t  ddActive[ 3 ];
+uint32_t ddCycle[ 3 ] = { 0, 0, 0 };
+uint8_t	 sampleValue[ 3 ] = { 0 };
+
+extern void outputDigi( uint8_t voice, int32_t value );
+
+typedef struct
+{
+	FM_OPL	 *pOPL;
+	uint32_t audioRate;		// output rate the FM engine runs at (follows AUDIO_RATE)
+	#ifdef SID_DAC_MODE_SUPPORT
+	int32_t  DAC_L, DAC_R;
+	#endif
+	uint8_t  sampleTechnique;
+	uint32_t lastD418Cycle;
+	uint32_t voice3PollEnd[ 2 ];	// the lookahead of voice 3 is computed until then (voice3Ahead.h)
+	#ifdef USE_RGB_LED
+	uint8_t  digiD418Visualization;
+	#endif
+} EMU_CORE_STATE;
+
+extern uint8_t  SID_DIGI_DETECT;	// from config: heuristics activated?
+extern uint32_t AUDIO_RATE;			// from config: output rate (reSIDWrapper.cc)
+
+//
+// OSC3/ENV3 ahead of the emulation (voice3Ahead.h), after the emulation reached 'cycle': recomputed when the
+// published one runs out, or when commands were applied after its start
+//
+__attribute__((always_inline)) static inline void emulationVoice3Ahead( EMU_CORE_STATE *emu, uint32_t cycle )
+{
+	for ( uint8_t sid = 0; sid < 2; sid ++ )
+	{
+		// a read between testing and clearing the flag is lost, but the lookahead is kept up anyway
+		if ( voice3Polled[ sid ] )
+		{
+			voice3Polled[ sid ] = 0;
+			emu->voice3PollEnd[ sid ] = cycle + VOICE3_POLL_HOLD;
+		}
+
+		if ( !TIME_AFTER( emu->voice3PollEnd[ sid ], cycle ) )
+			continue;
+
+		uint8_t b = voice3AheadBuf[ sid ];
+		VOICE3_AHEAD *v = &voice3Ahead[ sid ][ b ];
+		if ( cycle - v->cycle < VOICE3_AHEAD_REFRESH && TIME_AFTER( v->cycle, ringReadTime ) )
+		{
+			// outRegisters are at 'cycle': the bus core takes the entries before from there
+			v->first = ( cycle - v->cycle + ( 1 << VOICE3_AHEAD_SHIFT ) - 1 ) >> VOICE3_AHEAD_SHIFT;
+			continue;
+		}
+
+		b ^= 1;
+		v = &voice3Ahead[ sid ][ b ];
+		v->cycle = cycle;
+		v->first = 0;
+		predictVoice3( sid, v->osc3, v->env3, VOICE3_AHEAD_STEPS, 1 << VOICE3_AHEAD_SHIFT );
+		RING_STORE_RELEASE( voice3AheadBuf[ sid ], b );
+	}
+}
+
+//
+// processes all SID/FM-commands which are due, and emulates SID(s) up to the next command's time stamp
+// or to cycle 'until' (at most the current C64 cycle) if there is no command before. Returns 1 when the
+// emulation has reached 'until' and all commands up to then are processed, i.e. a sample for a tick at
+// that cycle can be rendered
+//
+__attribute__((always_inline)) static inline uint32_t emulationDrainRing( EMU_CORE_STATE *emu, uint32_t until )
+{
+	uint32_t targetEmulationCycle = until;
+	uint32_t reached = 1;
+
+	// all entries published so far (see busRing.h)
+	RING_BATCH batch;
+	ringBeginBatch( &batch );
+
+	#ifdef EMU_PROFILING
+	uint32_t tDrain = emuProfileNow();
+	uint8_t  drainWork = batch.read != batch.end;
+	#endif
+
+	while ( batch.read != batch.end )
+	{
+		register uint32_t entry = ringBuf[ batch.read ];
+
+		if ( RING_IS_SYNC( entry ) )
+		{
+			ringReadTime = ringSyncTime( entry, c64CycleCounter );
+			batch.read = RING_NEXT( batch.read );
+			continue;
+		}
+
+		uint32_t cmdTime = ringReadTime + RING_DELTA( entry );
+
+		#ifdef SID_DAC_MODE_SUPPORT
+		// this is placed here, as we don't use time stamps in DAC mode
+		if ( sidDACMode && !( entry & ( 1 << 15 ) ) )
+		{
+			register uint16_t cmd = RING_CMD( entry );
+			ringReadTime = cmdTime;
+			batch.read = RING_NEXT( batch.read );
+			ringCommandsRead ++;
+			uint8_t reg = ( cmd >> 8 ) & 0x1f;
+
+			if ( sidDACMode == SID_DAC_STEREO8 )
+			{
+				if ( reg == 0x18 )
+					emu->DAC_L = ( (int)( cmd & 255 ) - 128 ) << 7;
+				if ( reg == 0x19 )
+					emu->DAC_R = ( (int)( cmd & 255 ) - 128 ) << 7; 
+			} else
+			if ( sidDACMode == SID_DAC_MONO8 && reg == 0x18 )
+			{
+				emu->DAC_L = emu->DAC_R = ( (int)( cmd & 255 ) - 128 ) << 7;
+			}
+			continue;
+		} 
+		#endif
+
+
+		if ( TIME_AFTER( cmdTime, lastSIDEmulationCycle ) )
+		{
+			if ( !TIME_AFTER( cmdTime, until ) )
+			{
+				targetEmulationCycle = cmdTime;
+				reached = 0;
+			}
+			break;
+		}
+		
+		register uint16_t cmd = RING_CMD( entry );
+		ringReadTime = cmdTime;
+		batch.read = RING_NEXT( batch.read );
+		ringCommandsRead ++;
+
+		if ( cmd & ( 1 << 15 ) )
+		{
+			#ifdef U64BOARD
+			if ( FM_DYNAMIC_ENABLE )
+			#else
+			if ( FM_ENABLE )
+			#endif
+			{
+				ym3812_write( emu->pOPL, ( ( cmd >> 8 ) >> 4 ) & 1, cmd & 255 );
+			} else
+			{
+				writeReSID2( ( cmd >> 8 ) & 0x1f, cmd & 255 );
+			}
+		} else
+		{
+			uint8_t reg = cmd >> 8;
+
+			// this is a work-around if very early writes to SID-registers are missed due to boot-up time (and d418 is only set once)
+		#ifndef RESET_ON_GPIO
+			static uint8_t d418_volume_set = 0;
+			if ( !d418_volume_set )
+			{
+				if ( reg == 0x18 ) d418_volume_set = 1;
+				// on the 33rd command (as counted by the former 8-bit ring index), sync entries do not count
+				if ( ringCommandsRead == 33 )
+					writeReSID( 0x18, 15 );
+			}
+		#endif
+
+			#ifdef USE_RGB_LED
+			if ( reg == 0x18 )
+			{
+				if ( ( targetEmulationCycle - emu->lastD418Cycle ) < 1536 )
+				{
+					emu->digiD418Visualization = 1;
+
+					// heuristic to detect Mahoney's technique based on findings by Jürgen Wothke used in WebSid (https://bitbucket.org/wothke/websid/src/master/) )
+					if ( ( 0x17[ outRegisters ] == 0x3 ) && ( 0x15[ outRegisters ] >= 0xfe ) && ( 0x16[ outRegisters ] >= 0xfe ) &&
+						 ( 0x06[ outRegisters ] >= 0xfb ) && ( 0x06[ outRegisters ] == 0x0d[ outRegisters ] ) && ( 0x06[ outRegisters ] == 0x14[ outRegisters ] ) &&
+						 ( 0x04[ outRegisters ] == 0x49 ) && ( 0x0b[ outRegisters ] == 0x49 ) && ( 0x12[ outRegisters ] == 0x49 ) )
+						emu->digiD418Visualization = 2;
+				} else
+					emu->digiD418Visualization = 0;
+
+				emu->lastD418Cycle = targetEmulationCycle;
+			}
+			#endif
+
+			writeReSID( reg, cmd & 255 );
+
+			// pseudo stereo
+			if ( SID2_FLAG == ( 1u << 31 ) )
+				writeReSID2( reg, cmd & 255 );
+
+			#ifdef SUPPORT_DIGI_DETECT
+
+			//
+			// Digi-Playing Detection to bypass reSID
+			// (the heuristics below are based on the findings by J�rgen Wothke used in WebSid (https://bitbucket.org/wothke/websid/src/master/) )
+			//
+
+			if ( SID_DIGI_DETECT )
+			{
+				uint8_t voice = 0;
+				if ( reg >  6 && reg < 14 ) { voice = 1; reg -= 7; }
+				if ( reg > 13 && reg < 21 ) { voice = 2; reg -= 14; }
+
+				//
+				// test-bit technique
+
+				#define DD_STATE_TBC( state, cycle )	{ ddTB_state[ voice ] = state; ddTB_cycle[ voice ] = cycle; }
+				#define DD_STATE_TB( state )			{ ddTB_state[ voice ] = state; }
+				#define DD_NO_TIMEOUT( threshold )		( ( c64CycleCounter - ddTB_cycle[ voice ] ) < threshold )
+				
+				#define DD_GET_SAMPLE( s )	{	DD_STATE_TBC( DD_IDLE, 0 );					\
+												ddActive[ voice ] = emu->sampleTechnique = 2;	\
+												sampleValue[ voice ] = s;					\
+												ddCycle[ voice ] = c64CycleCounter; }
+
+				if ( reg == 4 )	
+				{	
+					uint8_t v = cmd & 0x19;
+					switch ( v ) 
+					{
+					case 0x11:	
+						DD_STATE_TBC( DD_PREP, c64CycleCounter );
+						break;
+					case 0x8: case 0x9:	
+						if ( ddTB_state[ voice ] == DD_PREP && DD_NO_TIMEOUT( DD_TB_TIMEOUT0 ) )
+							DD_STATE_TBC( DD_SET, c64CycleCounter - 4 ) else
+							DD_STATE_TB( DD_IDLE )
+						break;
+					case 0x1:	// GATE
+						if ( ddTB_state[ voice ] == DD_SET && DD_NO_TIMEOUT( DD_TB_TIMEOUT ) )
+							DD_STATE_TB( DD_VAR1 ) else
+						if ( ddTB_state[ voice ] == DD_VAR2 && DD_NO_TIMEOUT( DD_TB_TIMEOUT ) )
+							DD_GET_SAMPLE( ddTB_sample[ voice ] ) else
+							DD_STATE_TB( DD_IDLE )
+						break;
+					case 0x0:	
+						if ( ddTB_state[ voice ] == DD_VAR2 && DD_NO_TIMEOUT( DD_TB_TIMEOUT ) )
+							DD_GET_SAMPLE( ddTB_sample[ voice ] )
+						break;
+					}
+				} else
+				if ( reg == 1 ) 
+				{	
+					if ( ddTB_state[ voice ] == DD_SET && DD_NO_TIMEOUT( DD_TB_TIMEOUT ) )
+					{
+						ddTB_sample[ voice ] = cmd & 255;
+						DD_STATE_TBC( DD_VAR2, c64CycleCounter )
+					} else 
+					if ( ddTB_state[ voice ] == DD_VAR1 && DD_NO_TIMEOUT( DD_TB_TIMEOUT ) )
+						DD_GET_SAMPLE( cmd & 255 )
+				}
+
+				//
+				// pulse modulation technique
+				
+				#define DD_PWM_STATE_TBC( state, cycle )	{ ddPWM_state[ voice ] = state; ddPWM_cycle[ voice ] = cycle; }
+				#define DD_PWM_STATE_TB( state )			{ ddPWM_state[ voice ] = state; }
+				#define DD_PWM_NO_TIMEOUT( threshold )		( ( c64CycleCounter - ddPWM_cycle[ voice ] ) < threshold )
+
+				#define DD_PWM_GET_SAMPLE( s )	{	DD_PWM_STATE_TBC( DD_IDLE, 0 );				\
+													ddActive[ voice ] = emu->sampleTechnique = 1;	\
+													sampleValue[ voice ] = s;					\
+													ddCycle[ voice ] = c64CycleCounter; }
+
+				if ( reg == 4 ) 
+				{
+					uint8_t v = cmd & 0x49;	
+					switch ( v ) 
+					{
+					case 0x49:	
+						if ( ( ddPWM_state[ voice ] == DD_PREP ) && DD_PWM_NO_TIMEOUT( DD_PWM_TIMEOUT ) )
+							DD_PWM_STATE_TBC( DD_CONF, c64CycleCounter ) else
+							DD_PWM_STATE_TBC( DD_PREP2, c64CycleCounter ) 
+						break;
+					case 0x41:	
+						if ( ( ddPWM_state[ voice ] == DD_CONF || ddPWM_state[ voice ] == DD_CONF2 ) && DD_PWM_NO_TIMEOUT( DD_PWM_TIMEOUT ) )
+							DD_PWM_GET_SAMPLE( ddPWM_sample[ voice ] ) else
+							DD_PWM_STATE_TB( DD_IDLE )
+						break;
+					}
+				} else 
+				if ( reg == 2 ) 
+				{
+					if ( ( ddPWM_state[ voice ] == DD_PREP2 ) && DD_PWM_NO_TIMEOUT( DD_PWM_TIMEOUT ) )
+						DD_PWM_STATE_TBC( DD_CONF2, c64CycleCounter ) else
+						DD_PWM_STATE_TBC( DD_PREP, c64CycleCounter )
+					ddPWM_sample[ voice ] = cmd & 255;
+				}
+			}
+			#endif
+		}
+	} // while
+
+	ringEndBatch( &batch );
+
+	uint32_t curCycleCount = targetEmulationCycle;
+
+	#ifdef SID_DAC_MODE_SUPPORT
+	if ( !sidDACMode )
+	#endif
+	if ( TIME_AFTER( curCycleCount, lastSIDEmulationCycle ) )
+	{
+		#ifdef SUPPORT_DIGI_DETECT
+		if ( SID_DIGI_DETECT )
+		{
+			uint16_t v;
+
+			if ( c64CycleCounter - ddCycle[ 0 ] > 250 ) { ddActive[ 0 ] = 0; outputDigi( 0, 0 ); }
+			if ( c64CycleCounter - ddCycle[ 1 ] > 250 ) { ddActive[ 1 ] = 0; outputDigi( 1, 0 ); }
+			if ( c64CycleCounter - ddCycle[ 2 ] > 250 ) { ddActive[ 2 ] = 0; outputDigi( 2, 0 ); }
+
+			if ( ddActive[ 0 ] ) { *(int16_t *)&v = ( sampleValue[ 0 ] - 128 ) << 8; v &= ~3; v |= emu->sampleTechnique; outputDigi( 0, *(int16_t *)&v ); }
+			if ( ddActive[ 1 ] ) { *(int16_t *)&v = ( sampleValue[ 1 ] - 128 ) << 8; v &= ~3; v |= emu->sampleTechnique; outputDigi( 1, *(int16_t *)&v ); }
+			if ( ddActive[ 2 ] ) { *(int16_t *)&v = ( sampleValue[ 2 ] - 128 ) << 8; v &= ~3; v |= emu->sampleTechnique; outputDigi( 2, *(int16_t *)&v ); }
+
+			#ifdef USE_RGB_LED
+			if ( emu->sampleTechnique == 1 ) emu->digiD418Visualization = 2;
+			#endif
+		}
+		#endif
+
+		#ifdef EMU_PROFILING
+		EMU_PROFILE_END( PROF_DRAIN, tDrain )
+		drainWork = 0;
+		#endif
+
+		uint32_t cyclesToEmulate = curCycleCount - lastSIDEmulationCycle;
+		lastSIDEmulationCycle = curCycleCount;
+		EMU_PROFILE_START( tEmulate )
+		#ifdef U64BOARD
+		if ( FM_DYNAMIC_ENABLE )
+			emulateCyclesReSIDSingle( cyclesToEmulate ); else
+			emulateCyclesReSID( cyclesToEmulate );
+		#else
+		if ( FM_ENABLE )
+			emulateCyclesReSIDSingle( cyclesToEmulate ); else
+			emulateCyclesReSID( cyclesToEmulate );
+		#endif
+		EMU_PROFILE_END( PROF_EMULATE, tEmulate )
+
+		EMU_PROFILE_START( tReadRegs )
+		readRegs( &outRegisters[ 0x1b ], &outRegisters_2[ 0x1b ] );
+		EMU_PROFILE_END( PROF_READREGS, tReadRegs )
+
+		EMU_PROFILE_START( tVoice3 )
+		emulationVoice3Ahead( emu, curCycleCount );
+		EMU_PROFILE_END( PROF_VOICE3, tVoice3 )
+	}
+
+	#ifdef EMU_PROFILING
+	if ( drainWork ) EMU_PROFILE_END( PROF_DRAIN, tDrain )
+	#endif
+
+	return reached;
+}
+
+//
+// produces the next output sample (only called when handleBus() requests one)
+//
+__attribute__((always_inline)) static inline void emulationOutputSample( EMU_CORE_STATE *emu, int16_t *left, int16_t *right )
+{
+	int16_t L, R;
+
+	// output rate changed by updateConfiguration(): reSID is already set up, the FM engine starts over
+	if ( emu->audioRate != AUDIO_RATE )
+	{
+		emu->audioRate = AUDIO_RATE;
+		ym3812_set_rate( emu->pOPL, AUDIO_RATE );
+	}
+
+	#ifdef SID_DAC_MODE_SUPPORT
+	if ( sidDACMode )
+	{
+		L = emu->DAC_L;
+		R = emu->DAC_R;
+		#ifdef USE_RGB_LED
+		emu->digiD418Visualization = 2;
+		#endif
+	} else
+	#endif
+	#ifdef U64BOARD
+	if ( FM_DYNAMIC_ENABLE )
+	#else
+	if ( FM_ENABLE )
+	#endif
+	{
+		OPLSAMPLE fm;
+		EMU_PROFILE_START( tFM )
+		ym3812_update_one( emu->pOPL, &fm, 1 );
+		EMU_PROFILE_END( PROF_FM, tFM )
+
+		if ( hack_OPL_Sample_Enabled )
+			fm = ( (uint16_t)hack_OPL_Sample_Value[ 0 ] << 5 ) + ( (uint16_t)hack_OPL_Sample_Value[ 1 ] << 5 );
+
+		EMU_PROFILE_START( tMix )
+		#ifdef U64BOARD
+		extern void outputReSIDFMU64( int16_t * left, int16_t * right, int32_t fm, uint8_t fmHackEnable, uint8_t *fmDigis );
+		outputReSIDFMU64( &L, &R, (int32_t)fm, hack_OPL_Sample_Enabled, hack_OPL_Sample_Value );
+		#else
+		extern void outputReSIDFM( int16_t * left, int16_t * right, int32_t fm, uint8_t fmHackEnable, uint8_t *fmDigis );
+		outputReSIDFM( &L, &R, (int32_t)fm, hack_OPL_Sample_Enabled, hack_OPL_Sample_Value );
+		#endif
+		EMU_PROFILE_END( PROF_MIX, tMix )
+	} else
+	{
+		EMU_PROFILE_START( tMix )
+		outputReSID( &L, &R );
+		EMU_PROFILE_END( PROF_MIX, tMix )
+	}
+
+	*left = L;
+	*right = R;
+}
+
+#endif
@@ -673,7 +673,7 @@ static void advance(FM_OPL *OPL)
                 op->Cnt += (OPL->fn_tab[block_fnum & 0x03ff] >> (7 - block)) * op->mul;
             #else
                 uint32_t i = block_fnum & 0x03ff;
-                uint32_t tmp = (UINT32)( i * 73882 / 1024 * ( 1 << ( FREQ_SH - 10 ) ) ); /* -10 because chip works with 10.10 fixed point, while we use 16.16 */
+                uint32_t tmp = (UINT32)( i * OPL->freqbase_q16 / 1024 * ( 1 << ( FREQ_SH - 10 ) ) ); /* -10 because chip works with 10.10 fixed point, while we use 16.16 */
                 op->Cnt += ( tmp >> ( 7 - block ) ) * op->mul;
             #endif
 
@@ -1159,6 +1159,11 @@ void OPL_initalize(FM_OPL *OPL)
     /* frequency base */
     OPL->freqbase = (OPL->rate) ? ((float)OPL->clock / 72.0f) / OPL->rate : 0;
 
+#ifdef EVAL_FN_TAB
+    /* fixed point frequency base for evaluating the fnumber -> increment counter on the fly (rounded) */
+    OPL->freqbase_q16 = (OPL->rate) ? (UINT32)(((uint64_t)OPL->clock * 65536 + 36 * OPL->rate) / (72 * OPL->rate)) : 0;
+#endif
+
 #ifndef EVAL_FN_TAB
     /* make fnumber -> increment counter table */
     for (i = 0; i < 1024; i++) {
@@ -1543,9 +1548,9 @@ static void OPLWriteReg(FM_OPL *OPL, int r, int v)
                 //3579545, AUDIO_RATE
                 //OPL->freqbase = ( OPL->rate ) ? ( (float)OPL->clock / 72.0f ) / OPL->rate : 0;
 
-                // for 44.1kHz freqbase = 73882 / 64 / 1024
+                // freqbase_q16 = freqbase * 64 * 1024, e.g. 73882 for 44.1kHz
                 uint32_t i = block_fnum & 0x03ff;
-                uint32_t tmp = (UINT32)( i * 73882 / 1024 * ( 1 << ( FREQ_SH - 10 ) ) ); /* -10 because chip works with 10.10 fixed point, while we use 16.16 */
+                uint32_t tmp = (UINT32)( i * OPL->freqbase_q16 / 1024 * ( 1 << ( FREQ_SH - 10 ) ) ); /* -10 because chip works with 10.10 fixed point, while we use 16.16 */
                 CH->fc = tmp >> ( 7 - block );
             #endif
 
@@ -1838,6 +1843,14 @@ void ym3812_reset_chip(FM_OPL *chip)
     OPLResetChip(chip);
 }
 
+void ym3812_set_rate(FM_OPL *chip, UINT32 rate)
+{
+    /* the channel/operator increments depend on the rate: start over */
+    chip->rate = rate;
+    OPL_initalize(chip);
+    OPLResetChip(chip);
+}
+
 int ym3812_write(FM_OPL *chip, int a, int v)
 {
     return OPLWrite(chip, a, v);
@@ -111,6 +111,9 @@ typedef struct fm_opl_f {
     UINT32 clock;                                       /* master clock  (Hz)           */
     UINT32 rate;                                        /* sampling rate (Hz)           */
     float freqbase;                            /* frequency base               */
+#ifdef EVAL_FN_TAB
+    UINT32 freqbase_q16;                        /* frequency base * 64 * 1024 (fnumber->increment) */
+#endif
 } FM_OPL;
 
 /*
@@ -124,6 +127,11 @@ extern FM_OPL *ym3812_init(UINT32 clock, UINT32 rate);
 
 extern void ym3812_shutdown(FM_OPL *chip);
 extern void ym3812_reset_chip(FM_OPL *chip);
+
+/*
+ * Change the sampling rate: recomputes the rate dependent increments and resets the chip
+ */
+extern void ym3812_set_rate(FM_OPL *chip, UINT32 rate);
 extern int ym3812_write(FM_OPL *chip, int a, int v);
 extern unsigned char ym3812_read(FM_OPL *chip, int a);
 extern unsigned char ym3812_peek(FM_OPL *chip, int a);
@@ -0,0 +1,345 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  busModel.c
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// virtual C64 bus, see busModel.h. The firmware is compiled as part of this file, such that the model
+// can use the ring buffer functions (busRing.h) and the firmware's globals without duplicating them
+//
+
+// the firmware is written for the 32 bit RP2040/RP2350 and built without these warnings there
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpointer-to-int-cast"
+#pragma GCC diagnostic ignored "-Wpointer-sign"
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+#pragma GCC diagnostic ignored "-Wunused-label"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include "SKpico.c"
+#pragma GCC diagnostic pop
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "exodecr.h"
+#include "busModel.h"
+
+sio_hw_t     hostSio;
+iobank0_hw_t hostIOBank0;
+adc_hw_t     hostADC;
+
+uint32_t busModelContention = 0;
+BUS_FLASH_OP busModelFlashOps[ BUS_FLASH_MAX_OPS ];
+uint32_t busModelNumFlashOps = 0;
+uint8_t  busModelLastReset = 0;
+
+//
+// handshake between the model (presents half-cycles) and handleBus() (waits for them): busPresented counts
+// the half-cycles, busDone is the one handleBus() is done with, i.e. waiting for a later one
+//
+static uint32_t busPresented = 0;
+static uint32_t busDone = ~0u;
+static volatile uint8_t busStop = 0;
+static pthread_t busThread;
+
+#define BUS_LOAD_ACQUIRE( v )		__atomic_load_n( &(v), __ATOMIC_ACQUIRE )
+#define BUS_STORE_RELEASE( v, x )	__atomic_store_n( &(v), (x), __ATOMIC_RELEASE )
+
+// the model waits at most this long for handleBus() to finish a half-cycle
+#define BUS_TIMEOUT_SECONDS	10
+
+static void busSpin( uint32_t *spins )
+{
+	if ( ++ *spins > 16 )
+		sched_yield();
+}
+
+uint32_t hostBusWaitHalfCycle( uint32_t phi2 )
+{
+	while ( 1 )
+	{
+		uint32_t n = BUS_LOAD_ACQUIRE( busPresented );
+		if ( busStop )
+			pthread_exit( NULL );
+
+		uint32_t g = sio_hw->gpio_in;
+		if ( n && ( g & bPHI ) == phi2 )
+			return g;
+
+		BUS_STORE_RELEASE( busDone, n );
+
+		uint32_t spins = 0;
+		while ( BUS_LOAD_ACQUIRE( busPresented ) == n )
+			busSpin( &spins );
+	}
+}
+
+static void busWaitDone()
+{
+	uint32_t spins = 0;
+	time_t start = time( NULL );
+	while ( BUS_LOAD_ACQUIRE( busDone ) != busPresented )
+	{
+		busSpin( &spins );
+		if ( !( spins & 0xffff ) && time( NULL ) - start > BUS_TIMEOUT_SECONDS )
+		{
+			fprintf( stderr, "busModel: handleBus() did not finish half-cycle #%u\n", busPresented );
+			exit( 1 );
+		}
+	}
+}
+
+//
+// pins
+//
+static int busWire = BUS_WIRE_A8;
+static int busResetLow = 0;
+static uint8_t busDataOut = 0;
+static uint32_t busCycleCount = 0;
+
+void busModelSetWire( int wire ) { busWire = wire; }
+void busModelSetReset( int low ) { busResetLow = low; }
+uint32_t busModelCycles() { return busCycleCount; }
+
+static int busIOActive( uint16_t addr )
+{
+	return ( busWire == BUS_WIRE_IO1 && ( addr >> 8 ) == 0xde ) ||
+		   ( busWire == BUS_WIRE_IO2 && ( addr >> 8 ) == 0xdf );
+}
+
+static uint32_t busPins( int cpu, uint16_t addr, int write, uint8_t data )
+{
+	uint32_t g = bSID | bRW | ( 1 << A8 ) | ( busResetLow ? 0 : bRESET );
+
+	if ( !cpu )
+		return g;
+
+	g |= bPHI;
+	g |= ( addr & 31 ) << A0;
+
+	if ( addr & 32 )
+		g |= 1 << A5;
+
+	if ( busWire == BUS_WIRE_A8 ? !( addr & 256 ) : busIOActive( addr ) )
+		g &= ~( 1 << A8 );
+
+	if ( addr >= 0xd400 && addr < 0xd800 )
+		g &= ~bSID;
+
+	if ( write )
+		g = ( g & ~bRW ) | data; else
+		g |= 0xff;
+
+	return g;
+}
+
+// presents one half-cycle and waits until handleBus() is done with it, returns the driven data lines (mask)
+static uint32_t busHalfCycle( uint32_t pins )
+{
+	busWaitDone();
+
+	sio_hw->gpio_in = pins;
+	BUS_STORE_RELEASE( busPresented, busPresented + 1 );
+
+	busWaitDone();
+
+	// SET_DATA writes both, set and clear, of the data lines
+	busDataOut = ( busDataOut | sio_hw->gpio_set ) & ~sio_hw->gpio_clr;
+	sio_hw->gpio_set = sio_hw->gpio_clr = 0;
+
+	return sio_hw->gpio_oe & 0xff;
+}
+
+// requests of handleBus() to the emulation core, served between the cycles
+static void busServeRequests()
+{
+	if ( decompressConfig )
+	{
+		exo_decrunch( (const char *)&prgCodeCompressed[ prgCodeCompressed_size ], (char *)&prgCode[ prgCode_size ] );
+		decompressConfig = 0;
+	}
+	if ( doReset )
+	{
+		busModelLastReset = doReset;
+		doReset = 0;
+	}
+}
+
+static void busContention( const char *what, uint16_t addr )
+{
+	if ( busModelContention ++ < 10 )
+		fprintf( stderr, "busModel: data lines driven in %s (cycle %u, $%04x)\n", what, busCycleCount, addr );
+}
+
+int busModelCycle( uint16_t addr, int write, uint8_t data )
+{
+	busCycleCount ++;
+
+	if ( busHalfCycle( busPins( 0, 0, 0, 0 ) ) )
+		busContention( "the VIC half-cycle", addr );
+
+	uint32_t driven = busHalfCycle( busPins( 1, addr, write, data ) );
+
+	busServeRequests();
+
+	if ( !driven )
+		return -1;
+
+	int selected = ( addr >= 0xd400 && addr < 0xd800 ) || busIOActive( addr );
+	if ( write || !selected )
+		busContention( write ? "a write cycle" : "a cycle not addressing the SIDKick", addr );
+
+	return busDataOut;
+}
+
+void busModelIdle( uint32_t cycles )
+{
+	while ( cycles -- )
+		busModelCycle( 0x0800, 0, 0 );
+}
+
+uint32_t busModelPopCommands( uint16_t *cmd, uint32_t *time, uint32_t n )
+{
+	uint32_t e[ 64 ], nCmd = 0;
+
+	while ( nCmd < n )
+	{
+		uint32_t m = ringPopBatch( e, n - nCmd < 64 ? n - nCmd : 64 );
+		if ( !m ) break;
+
+		for ( uint32_t i = 0; i < m; i ++ )
+		{
+			if ( RING_IS_SYNC( e[ i ] ) )
+			{
+				ringReadTime = ringSyncTime( e[ i ], c64CycleCounter );
+				continue;
+			}
+			ringReadTime += RING_DELTA( e[ i ] );
+			cmd[ nCmd ] = RING_CMD( e[ i ] );
+			time[ nCmd ++ ] = ringReadTime;
+		}
+	}
+	return nCmd;
+}
+
+//
+// flash
+//
+uint32_t busModelFlashOffset( const volatile void *p )
+{
+	return (uint32_t)(uintptr_t)p - XIP_BASE;
+}
+
+// bytes from p to the end of the firmware buffer it points into: the firmware programs whole sectors/slots,
+// i.e. reads past the end of prgDirectory, prgCode and config (which on the device is just other RAM)
+static size_t busFlashSourceSize( const uint8_t *p )
+{
+	const struct { const uint8_t *buf; size_t size; } sources[] = {
+		{ prgDirectory, sizeof( prgDirectory ) },
+		{ prgCode, sizeof( prgCode ) },
+		{ config, sizeof( config ) },
+	};
+
+	for ( size_t i = 0; i < sizeof( sources ) / sizeof( sources[ 0 ] ); i ++ )
+		if ( p >= sources[ i ].buf && p < sources[ i ].buf + sources[ i ].size )
+			return sources[ i ].buf + sources[ i ].size - p;
+
+	return 0;
+}
+
+static void busFlashOp( uint8_t op, uint32_t offset, const uint8_t *data, size_t size )
+{
+	if ( busModelNumFlashOps >= BUS_FLASH_MAX_OPS )
+		return;
+
+	BUS_FLASH_OP *f = &busModelFlashOps[ busModelNumFlashOps ++ ];
+	f->op = op;
+	f->offset = offset;
+	f->size = size;
+	f->data = NULL;
+	f->dataSize = 0;
+	if ( data )
+	{
+		// the part within the source buffer (zero-filled to size), nothing for unknown sources
+		size_t n = busFlashSourceSize( data );
+		if ( n > size ) n = size;
+		if ( n && ( f->data = (uint8_t *)calloc( size, 1 ) ) )
+		{
+			memcpy( f->data, data, n );
+			f->dataSize = n;
+		}
+	}
+}
+
+void flash_range_erase( uint32_t flash_offs, size_t count )
+{
+	busFlashOp( BUS_FLASH_ERASE, flash_offs, NULL, count );
+}
+
+void flash_range_program( uint32_t flash_offs, const uint8_t *data, size_t count )
+{
+	busFlashOp( BUS_FLASH_PROGRAM, flash_offs, data, count );
+}
+
+//
+// start/stop
+//
+static void *busThreadMain( void *arg )
+{
+	(void)arg;
+	handleBus();
+	return NULL;
+}
+
+void busModelStart()
+{
+	// as main() and the start of runEmulation() on the device
+	readConfiguration();
+	initGPIOs();
+	initPotGPIOs();
+	initReSID();
+	updateEmulationParameters();
+	exo_decrunch( (const char *)&prgCodeCompressed[ prgCodeCompressed_size ], (char *)&prgCode[ prgCode_size ] );
+	ringInit();
+
+	busStop = 0;
+	busPresented = 0;
+	busDone = ~0u;
+	sio_hw->gpio_in = busPins( 0, 0, 0, 0 );
+
+	pthread_create( &busThread, NULL, busThreadMain, NULL );
+}
+
+void busModelStop()
+{
+	busWaitDone();
+	busStop = 1;
+	BUS_STORE_RELEASE( busPresented, busPresented + 1 );
+	pthread_join( busThread, NULL );
+}
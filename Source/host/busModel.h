@@ -0,0 +1,112 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  busModel.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// virtual C64 bus for the firmware's handleBus() (SKpico.c compiled for the host): handleBus() runs on
+// its own thread, the caller drives the bus cycle by cycle -- PHI2, R/W, A0-A5, A8 (or IO1/IO2, depending
+// on how the wire is connected), chip select, reset and the data lines on writes -- and gets back what
+// the firmware put on the data lines. Both sides run in lockstep: each half-cycle is handed to handleBus()
+// when it waits for it, and the next one is not presented before handleBus() waits again, i.e. the model
+// checks the logic of the state machines, not their timing (see busCycles.py for that).
+//
+// the model also plays the part of the emulation core for the requests handleBus() makes to it (config
+// tool decompression, reset), and reads the ring buffer as the emulation core would.
+//
+
+#ifndef _SKPICO_BUSMODEL_H_
+#define _SKPICO_BUSMODEL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// what the SIDKick's A8 pin is connected to
+#define BUS_WIRE_A8		0		// address line A8: SID #2 at $D420, $D500, $D520
+#define BUS_WIRE_IO1	1		// IO1 ($DE00-$DEFF), for SID #2 at $DE00
+#define BUS_WIRE_IO2	2		// IO2 ($DF00-$DFFF), for SID #2 at $DF00
+
+// sets up the firmware as main() does and starts handleBus() on its own thread
+extern void busModelStart();
+extern void busModelStop();
+
+extern void busModelSetWire( int wire );
+extern void busModelSetReset( int low );
+
+// one C64 cycle: the VIC half-cycle, then the CPU accessing 'addr' (reading if 'write' is 0); returns the
+// value the SIDKick put on the data lines, or -1 if it did not drive them
+extern int  busModelCycle( uint16_t addr, int write, uint8_t data );
+
+// cycles in which the CPU does not access the I/O area
+extern void busModelIdle( uint32_t cycles );
+
+// C64 cycles since busModelStart()
+extern uint32_t busModelCycles();
+
+// commands handleBus() pushed to the ring since the last call, with their time stamps (c64CycleCounter)
+extern uint32_t busModelPopCommands( uint16_t *cmd, uint32_t *time, uint32_t n );
+
+// half-cycles in which the data lines were driven although the CPU was not reading from the SIDKick
+extern uint32_t busModelContention;
+
+// flash accesses (flash_range_erase/program), offsets as computed by the firmware
+#define BUS_FLASH_ERASE		0
+#define BUS_FLASH_PROGRAM	1
+#define BUS_FLASH_MAX_OPS	64
+
+typedef struct
+{
+	uint8_t  op;
+	uint32_t offset, size;
+	uint8_t  *data;					// copy of the programmed data (NULL for erasing), size bytes
+	uint32_t dataSize;				// ... of which the first dataSize are copied from the source buffer
+} BUS_FLASH_OP;
+
+extern BUS_FLASH_OP busModelFlashOps[ BUS_FLASH_MAX_OPS ];
+extern uint32_t busModelNumFlashOps;
+
+extern uint32_t busModelFlashOffset( const volatile void *p );
+
+// set by handleBus() for the emulation core: 1 = reset, 2 = factory reset, 3 = next bus timing preset
+extern uint8_t busModelLastReset;
+
+// firmware state (SKpico.c, prgconfig.h, launch.h, reSIDWrapper.cc, prgslots.cc)
+extern uint8_t  config[ 64 ];
+extern unsigned char prgCode[];
+extern const int prgCode_size;
+extern const uint8_t launchCode[];
+extern const int launchSize;
+extern uint8_t  prgDirectory[ 16 * 24 + 1 ];
+extern const uint8_t prgDirectory_Flash[ 16 * 24 + 1 ];
+extern const uint8_t prgRepository[ 1024 * 1024 ];
+extern uint32_t c64CycleCounter;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,254 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  hostEmulation.c
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+// same feature set as SKpico.c
+#define SUPPORT_DIGI_DETECT
+#define SID_DAC_MODE_SUPPORT
+#define RESET_ON_GPIO
+
+#include "hostGlue.h"
+#include "hostEmulation.h"
+#include "reSIDWrapper.h"
+
+#define SID_DAC_OFF      0
+#define SID_DAC_MONO8    1
+#define SID_DAC_STEREO8  2
+uint8_t sidDACMode = SID_DAC_OFF;
+
+uint32_t c64CycleCounter = 0;
+
+volatile uint32_t lastSIDEmulationCycle = 0;
+
+uint8_t hack_OPL_Sample_Value[ 2 ];
+uint8_t hack_OPL_Sample_Enabled;
+
+#include "busRing.h"
+
+void resetEverything() 
+{
+	ringInit();
+}
+
+#include "emulationCore.h"
+#include "sampleClock.h"
+
+static EMU_CORE_STATE emu;
+static FM_OPL  *pOPL;
+static SAMPLE_CLOCK sampleClock;
+static uint32_t nextSampleCycle;
+static uint8_t  mOPL_addr;
+
+uint32_t *hostDeltaHistogram = NULL;
+uint32_t *hostVoice3LagHistogram[ 2 ] = { NULL, NULL };
+uint32_t  hostStartCycle = 0;
+
+void hostEmulationInit()
+{
+	// a fresh chip each time (ym3812_reset_chip() does not reset phase counters and LFOs)
+	pOPL = ym3812_init( 3579545, AUDIO_RATE );
+
+	for ( int i = 0x40; i < 0x56; i++ )
+	{
+		ym3812_write( pOPL, 0, i );
+		ym3812_write( pOPL, 1, 63 );
+	}
+	hack_OPL_Sample_Value[ 0 ] = hack_OPL_Sample_Value[ 1 ] = 64;
+	hack_OPL_Sample_Enabled = 0;
+	mOPL_addr = 0;
+
+	memset( &emu, 0, sizeof( EMU_CORE_STATE ) );
+	emu.pOPL = pOPL;
+	emu.audioRate = AUDIO_RATE;
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		ddTB_state[ i ] = ddPWM_state[ i ] = DD_IDLE;
+		ddTB_cycle[ i ] = ddPWM_cycle[ i ] = ddCycle[ i ] = 0;
+		ddTB_sample[ i ] = ddPWM_sample[ i ] = ddActive[ i ] = sampleValue[ i ] = 0;
+	}
+
+	sidDACMode = SID_DAC_OFF;
+	c64CycleCounter = lastSIDEmulationCycle = hostStartCycle;
+	nextSampleCycle = sampleClockStart( &sampleClock, hostStartCycle );
+	resetEverything();
+	ringLastTime = ringReadTime = hostStartCycle;
+	ringHighWater = ringOverflows = 0;
+
+	sampleFifoWrite = sampleFifoRead = sampleRequests = sampleRendered = 0;
+	sampleFifoLate = sampleFifoUnderruns = sampleFifoOverflows = 0;
+	sampleFifoPriming = 1;
+
+	memset( voice3Ahead, 0, sizeof( voice3Ahead ) );
+	for ( int i = 0; i < 2; i++ )
+	{
+		voice3Ahead[ i ][ 0 ].cycle = voice3Ahead[ i ][ 1 ].cycle = hostStartCycle - ( VOICE3_AHEAD_STEPS << VOICE3_AHEAD_SHIFT );
+		voice3AheadBuf[ i ] = voice3Polled[ i ] = 0;
+	}
+
+	#ifdef EMU_PROFILING
+	emuProfileInit();
+	#endif
+}
+
+int hostBusCycle()
+{
+	// we have to generate a new sample after C64_CLOCK / AUDIO_RATE cycles
+	if ( SAMPLE_DUE( ++ c64CycleCounter, nextSampleCycle ) )
+	{
+		nextSampleCycle = sampleClockAdvance( &sampleClock, nextSampleCycle, c64CycleCounter );
+
+		// as the PWM output of handleBus(), the samples themselves are returned by hostEmulationRun()
+		uint16_t v[ 2 ];
+		sampleFifoTick( c64CycleCounter, v );
+		return 1;
+	}
+	return 0;
+}
+
+// write-side of handleBus()
+void hostBusWrite( uint8_t chip, uint8_t A, uint8_t D )
+{
+	uint8_t *reg = outRegisters + ( chip == HOST_CHIP_SID1 ? 0 : 34 );
+
+	if ( A == 0x1f )
+	{
+		if ( D == 0xfc )
+			sidDACMode = SID_DAC_MONO8; else
+		if ( D == 0xfb )
+			sidDACMode = SID_DAC_STEREO8; else
+		if ( D == 0xfa )
+			sidDACMode = SID_DAC_OFF;
+		// config mode (0xff) and DAC-reset (0xf9) are not handled in replay
+		return;
+	}
+
+	if ( chip == HOST_CHIP_FM )
+	{
+		if ( ( A & 16 ) == 0 )
+		{
+			mOPL_addr = D;
+		} else
+		{
+			if ( mOPL_addr == 1 )
+			{
+				if ( D == 4 )
+					hack_OPL_Sample_Enabled = 128;  else
+					hack_OPL_Sample_Enabled = 0;
+			}
+			if ( hack_OPL_Sample_Enabled && ( mOPL_addr == 0xa0 || mOPL_addr == 0xa1 ) ) // digi hack
+			{
+				hack_OPL_Sample_Enabled |= 1 << ( mOPL_addr - 0xa0 );
+				hack_OPL_Sample_Value[ mOPL_addr - 0xa0 ] = D;
+			} else
+			{
+				hack_OPL_Sample_Value[ 0 ] = hack_OPL_Sample_Value[ 1 ] = 0;
+			}
+		}
+
+		ringPush( ( A << 8 ) | D | ( 1 << 15 ), c64CycleCounter );
+	} else
+	{
+		uint16_t SID_CMD = ( A << 8 ) | D;
+		if ( chip == HOST_CHIP_SID2 ) SID_CMD |= 1 << 15;
+
+		ringPush( SID_CMD, c64CycleCounter );
+
+		reg[ A ] = D;
+	}
+}
+
+// read-side of handleBus() (without model-detection and config-tool launch)
+uint8_t hostBusRead( uint8_t chip, uint8_t A )
+{
+	uint8_t *reg = outRegisters + ( chip == HOST_CHIP_SID1 ? 0 : 34 );
+
+	if ( chip == HOST_CHIP_FM )
+		return 0xff;
+
+	if ( A >= 0x1b && A <= 0x1c )
+	{
+		if ( hostVoice3LagHistogram[ 0 ] )
+		{
+			// how old the value is, with the lookahead and with the emulation's registers only
+			const VOICE3_AHEAD *v = voice3AheadCurrent( chip );
+			int32_t k = voice3AheadIndex( v, c64CycleCounter, ringLastTime );
+			uint32_t lag = c64CycleCounter - lastSIDEmulationCycle;
+			uint32_t lagAhead = k < 0 ? lag : c64CycleCounter - ( v->cycle + ( k << VOICE3_AHEAD_SHIFT ) );
+
+			hostVoice3LagHistogram[ 0 ][ lagAhead < HOST_LAG_HISTOGRAM_SIZE ? lagAhead : HOST_LAG_HISTOGRAM_SIZE - 1 ] ++;
+			hostVoice3LagHistogram[ 1 ][ lag < HOST_LAG_HISTOGRAM_SIZE ? lag : HOST_LAG_HISTOGRAM_SIZE - 1 ] ++;
+		}
+		uint8_t D = voice3AheadRead( reg, A, c64CycleCounter );
+		voice3AheadPolled( reg );
+		return D;
+	}
+
+	if ( A >= 0x19 && A <= 0x1a )
+		return reg[ A ];
+
+	return 0;
+}
+
+int hostEmulationRun( int16_t *left, int16_t *right )
+{
+	// as runEmulation(): up to the tick of the next sample due, or to the current cycle
+	uint32_t sampleCycle, reached;
+	uint32_t sampleDue = sampleFifoDue( &sampleCycle );
+
+	do {
+		uint32_t prevEmulationCycle = lastSIDEmulationCycle;
+
+		reached = emulationDrainRing( &emu, sampleDue ? sampleCycle : c64CycleCounter );
+
+		if ( hostDeltaHistogram && lastSIDEmulationCycle != prevEmulationCycle )
+		{
+			uint32_t d = lastSIDEmulationCycle - prevEmulationCycle;
+			hostDeltaHistogram[ d < HOST_DELTA_HISTOGRAM_SIZE ? d : HOST_DELTA_HISTOGRAM_SIZE - 1 ] ++;
+		}
+	} while ( !reached );
+
+	if ( sampleDue )
+	{
+		sampleFifoTake();
+		emulationOutputSample( &emu, left, right );
+		sampleFifoPush( *left, *right );
+		#ifdef EMU_PROFILING
+		emuProfileSampleDone();
+		#endif
+		return 1;
+	}
+	return 0;
+}
+
+#ifdef EMU_PROFILING
+const uint8_t *hostEmulationProfile()
+{
+	emuProfileExportStats();
+	return emuProfileExport;
+}
+#endif
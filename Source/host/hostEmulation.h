@@ -0,0 +1,90 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  hostEmulation.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// host-side stand-in for handleBus(): the C64 bus is driven cycle by cycle by the caller 
+// (e.g. from a bus trace), SID/FM accesses are decoded like on the device and end up in the 
+// same ring buffer, which is then processed by the emulation core of the firmware (emulationCore.h)
+//
+
+#ifndef _SKPICO_HOSTEMULATION_H_
+#define _SKPICO_HOSTEMULATION_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_CHIP_SID1	0
+#define HOST_CHIP_SID2	1
+#define HOST_CHIP_FM	2
+
+extern uint32_t c64CycleCounter;
+extern uint8_t  sidDACMode;
+
+// ring buffer telemetry (busRing.h), reset by hostEmulationInit()
+extern volatile uint32_t ringHighWater, ringOverflows;
+
+// sample FIFO telemetry (sampleFifo.h), reset by hostEmulationInit()
+extern volatile uint32_t sampleFifoLate, sampleFifoUnderruns, sampleFifoOverflows;
+
+// resets bus, ring buffer, digi-detection and FM chip (reSID needs to be initialized before)
+extern void hostEmulationInit();
+
+// value of the (wrapping 32-bit) cycle counter after hostEmulationInit(), e.g. to test the wrap-around
+extern uint32_t hostStartCycle;
+
+// advances the bus by one C64 cycle, returns 1 if a new output sample is due
+extern int  hostBusCycle();
+
+// SID/FM access in the current cycle; 'A' is the register as seen by handleBus (FM: 0x00 address, 0x10 data port)
+extern void hostBusWrite( uint8_t chip, uint8_t A, uint8_t D );
+extern uint8_t hostBusRead( uint8_t chip, uint8_t A );
+
+// if set, counts how many cycles reSID is clocked per call (the delta_t seen by SID16::clock), clamped to the last bin
+#define HOST_DELTA_HISTOGRAM_SIZE	1024
+extern uint32_t *hostDeltaHistogram;
+
+// if set (both), counts how many cycles the values of OSC3/ENV3 reads lag behind the bus: [ 0 ] as returned
+// (with the lookahead of voice3Ahead.h), [ 1 ] from the emulated registers only; clamped to the last bin
+#define HOST_LAG_HISTOGRAM_SIZE	1024
+extern uint32_t *hostVoice3LagHistogram[ 2 ];
+
+// one pass of the emulation core: processes pending commands, emulates up to the current cycle,
+// returns 1 and the sample if one was due (call again for further ones when the core was late)
+extern int  hostEmulationRun( int16_t *left, int16_t *right );
+
+#ifdef EMU_PROFILING
+// statistics of the emulation loop since hostEmulationInit(), as the C64 reads them in config mode (layout see emuProfile.h)
+extern const uint8_t *hostEmulationProfile();
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
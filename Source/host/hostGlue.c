@@ -0,0 +1,40 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  hostGlue.c
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hostGlue.h"
+
+// pin assignment as in SKpico.c (only needed to derive the SID #2 address flags)
+#define A5			14
+#define A8			15
+#define SID			21
+#define bSID		( 1 << SID )
+
+uint8_t DIAGROM_THRESHOLD;
+
+const uint32_t sidFlags[ 6 ] = { bSID, ( 1 << A5 ), ( 1 << A8 ), ( 1 << A5 ) | ( 1 << A8 ), ( 1 << A8 ), ( 1 << A8 ) };
+
+uint8_t outRegisters[ 34 * 2 ];
+uint8_t *outRegisters_2 = &outRegisters[ 34 ];
@@ -0,0 +1,79 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  hostGlue.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 
+// glue for building the emulation core (reSID16, fmopl, exodecr, reSIDWrapper) on a 
+// desktop machine: declarations of the wrapper functions, which SKpico.c declares locally,
+// and of the few globals the wrapper expects to be provided by the firmware
+//
+
+#ifndef _SKPICO_HOSTGLUE_H_
+#define _SKPICO_HOSTGLUE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "fmopl.h"
+
+extern uint8_t  config[ 64 ];
+extern uint32_t C64_CLOCK;
+extern uint32_t AUDIO_RATE;
+extern uint8_t  FM_ENABLE;
+extern uint32_t SID2_FLAG;
+extern uint8_t  SID_DIGI_DETECT;
+
+// provided by hostGlue.c (live in SKpico.c on the device)
+extern uint8_t  outRegisters[ 34 * 2 ];
+extern uint8_t  *outRegisters_2;
+extern const uint32_t sidFlags[ 6 ];
+extern uint8_t  DIAGROM_THRESHOLD;
+extern void resetEverything();		// hostEmulation.c
+
+// reSIDWrapper.cc
+extern void setDefaultConfiguration();
+extern void initReSID();
+extern void resetReSID();
+extern void updateConfiguration();
+extern void emulateCyclesReSID( int cyclesToEmulate );
+extern void emulateCyclesReSIDSingle( int cyclesToEmulate );
+extern void writeReSID( uint8_t A, uint8_t D );
+extern void writeReSID2( uint8_t A, uint8_t D );
+extern void outputDigi( uint8_t voice, int32_t value );
+extern void outputReSID( int16_t *left, int16_t *right );
+extern void outputReSIDFM( int16_t *left, int16_t *right, int32_t fm, uint8_t fmHackEnable, uint8_t *fmDigis );
+extern void readRegs( uint8_t *p1, uint8_t *p2 );
+extern void predictVoice3( uint8_t sid, uint8_t *osc3, uint8_t *env3, int n, int step );
+extern uint8_t readSID( uint8_t offset );
+extern uint8_t readSID2( uint8_t offset );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,32 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_HARDWARE_ADC_H_
+#define _SKPICO_HOST_HARDWARE_ADC_H_
+
+#include "pico.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// POTY via the ADC (config[ 57 ]): the result register is whatever the bus model sets
+typedef struct
+{
+	volatile uint32_t cs, result;
+} adc_hw_t;
+
+extern adc_hw_t hostADC;
+#define adc_hw	( &hostADC )
+
+#define ADC_CS_EN_BITS	0x00000001
+
+static inline void adc_init() { adc_hw->cs = ADC_CS_EN_BITS; }
+static inline void adc_gpio_init( uint gpio ) { (void)gpio; }
+static inline void adc_select_input( uint input ) { (void)input; }
+static inline void adc_run( bool run ) { (void)run; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,16 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_HARDWARE_CLOCKS_H_
+#define _SKPICO_HOST_HARDWARE_CLOCKS_H_
+
+#include "pico.h"
+
+// the firmware switches between 125MHz and the overclocked speed around flash 
+// accesses and table setup -- there is no such thing on the host
+static inline bool set_sys_clock_pll( uint32_t vco_freq, uint post_div1, uint post_div2 )
+{
+	(void)vco_freq; (void)post_div1; (void)post_div2;
+	return true;
+}
+
+#endif
@@ -0,0 +1,25 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_HARDWARE_FLASH_H_
+#define _SKPICO_HOST_HARDWARE_FLASH_H_
+
+#include "pico.h"
+
+#define FLASH_PAGE_SIZE		( 1u << 8 )
+#define FLASH_SECTOR_SIZE	( 1u << 12 )
+
+#define XIP_BASE			0x10000000
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// recorded by the bus model (busModel.c), the flash contents are not changed
+extern void flash_range_erase( uint32_t flash_offs, size_t count );
+extern void flash_range_program( uint32_t flash_offs, const uint8_t *data, size_t count );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
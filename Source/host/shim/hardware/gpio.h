@@ -0,0 +1,67 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_HARDWARE_GPIO_H_
+#define _SKPICO_HOST_HARDWARE_GPIO_H_
+
+#include "pico.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the pins as seen by handleBus(): gpio_in is driven by the bus model (busModel.c), which also
+// picks up what the firmware puts on the data lines via gpio_set/gpio_clr and gpio_oe
+typedef struct
+{
+	volatile uint32_t gpio_in;
+	volatile uint32_t gpio_set;
+	volatile uint32_t gpio_clr;
+	volatile uint32_t gpio_oe;
+} sio_hw_t;
+
+extern sio_hw_t hostSio;
+#define sio_hw	( &hostSio )
+
+typedef struct
+{
+	struct { volatile uint32_t status, ctrl; } io[ 30 ];
+} iobank0_hw_t;
+
+extern iobank0_hw_t hostIOBank0;
+#define iobank0_hw	( &hostIOBank0 )
+
+#define IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB	0
+
+#define GPIO_OUT	1
+#define GPIO_IN		0
+
+enum gpio_function { GPIO_FUNC_PWM = 4, GPIO_FUNC_SIO = 5, GPIO_FUNC_NULL = 0x1f };
+enum gpio_drive_strength { GPIO_DRIVE_STRENGTH_2MA, GPIO_DRIVE_STRENGTH_4MA, GPIO_DRIVE_STRENGTH_8MA, GPIO_DRIVE_STRENGTH_12MA };
+
+// pin directions are tracked, the pad configuration is not
+static inline void gpio_init( uint gpio ) { (void)gpio; }
+static inline void gpio_set_pulls( uint gpio, bool up, bool down ) { (void)gpio; (void)up; (void)down; }
+static inline void gpio_set_function( uint gpio, enum gpio_function fn ) { (void)gpio; (void)fn; }
+static inline void gpio_set_drive_strength( uint gpio, enum gpio_drive_strength drive ) { (void)gpio; (void)drive; }
+static inline void gpio_put( uint gpio, bool value ) { (void)gpio; (void)value; }
+
+static inline void gpio_set_dir_all_bits( uint32_t values )
+{
+	sio_hw->gpio_oe = values;
+}
+
+static inline void gpio_set_dir_masked( uint32_t mask, uint32_t value )
+{
+	sio_hw->gpio_oe = ( sio_hw->gpio_oe & ~mask ) | ( value & mask );
+}
+
+static inline void gpio_set_dir( uint gpio, bool out )
+{
+	gpio_set_dir_masked( 1u << gpio, out ? ~0u : 0u );
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,10 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_HARDWARE_IRQ_H_
+#define _SKPICO_HOST_HARDWARE_IRQ_H_
+
+#include "pico.h"
+
+static inline void irq_set_mask_enabled( uint32_t mask, bool enabled ) { (void)mask; (void)enabled; }
+
+#endif
@@ -0,0 +1,15 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_HARDWARE_PIO_H_
+#define _SKPICO_HOST_HARDWARE_PIO_H_
+
+#include "pico.h"
+
+// the PIO drives the RGB LED and the I2S output
+typedef struct pio_hw *PIO;
+#define pio0	( (PIO)0 )
+
+static inline void pio_sm_put( PIO pio, uint sm, uint32_t data ) { (void)pio; (void)sm; (void)data; }
+static inline void pio_sm_set_clkdiv_int_frac( PIO pio, uint sm, uint16_t div_int, uint8_t div_frac ) { (void)pio; (void)sm; (void)div_int; (void)div_frac; }
+
+#endif
@@ -0,0 +1,21 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_HARDWARE_PWM_H_
+#define _SKPICO_HOST_HARDWARE_PWM_H_
+
+#include "pico.h"
+
+// audio and LED output via PWM: nothing to see on the host
+typedef struct
+{
+	uint32_t csr, div, top;
+} pwm_config;
+
+static inline uint pwm_gpio_to_slice_num( uint gpio ) { return ( gpio >> 1 ) & 7; }
+static inline pwm_config pwm_get_default_config() { pwm_config c = { 0, 1 << 4, 0xffff }; return c; }
+static inline void pwm_config_set_clkdiv( pwm_config *c, float div ) { c->div = (uint32_t)( div * 16 ); }
+static inline void pwm_config_set_wrap( pwm_config *c, uint16_t wrap ) { c->top = wrap; }
+static inline void pwm_init( uint slice_num, pwm_config *c, bool start ) { (void)slice_num; (void)c; (void)start; }
+static inline void pwm_set_gpio_level( uint gpio, uint16_t level ) { (void)gpio; (void)level; }
+
+#endif
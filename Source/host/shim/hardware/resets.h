@@ -0,0 +1,10 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_HARDWARE_RESETS_H_
+#define _SKPICO_HOST_HARDWARE_RESETS_H_
+
+#include "pico.h"
+
+// nothing used from here
+
+#endif
@@ -0,0 +1,10 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_HARDWARE_VREG_H_
+#define _SKPICO_HOST_HARDWARE_VREG_H_
+
+#include "pico.h"
+
+// only used by main(), which the host build does not have
+
+#endif
@@ -0,0 +1,11 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_HARDWARE_WATCHDOG_H_
+#define _SKPICO_HOST_HARDWARE_WATCHDOG_H_
+
+#include "pico.h"
+
+// reboots after a factory reset or a change of the bus timings, which the bus model does not go through
+static inline void watchdog_reboot( uint32_t pc, uint32_t sp, uint32_t delay_ms ) { (void)pc; (void)sp; (void)delay_ms; }
+
+#endif
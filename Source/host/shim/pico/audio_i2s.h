@@ -0,0 +1,10 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_PICO_AUDIO_I2S_H_
+#define _SKPICO_HOST_PICO_AUDIO_I2S_H_
+
+#include "pico.h"
+
+// I2S output (USE_DAC) is not part of the host build
+
+#endif
@@ -0,0 +1,8 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_PICO_MULTICORE_H_
+#define _SKPICO_HOST_PICO_MULTICORE_H_
+
+#include "pico.h"
+
+#endif
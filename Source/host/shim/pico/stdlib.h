@@ -0,0 +1,12 @@
+// host shim: see ../pico.h
+
+#ifndef _SKPICO_HOST_PICO_STDLIB_H_
+#define _SKPICO_HOST_PICO_STDLIB_H_
+
+#include <stdlib.h>
+
+#include "pico.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#endif
@@ -0,0 +1,358 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  skpico_bench.cc
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// throughput benchmark of the emulation core on the host: replays a synthetic, deterministic
+// tune (SID register writes every frame, optionally OPL writes) the same way runEmulation() 
+// does on the device, i.e. emulate up to each write, then render one sample per 1/AUDIO_RATE s
+//
+// each configuration is run with all reSID accuracy tiers (CFG_EMULATION_ACCURACY): the cost relative
+// to delta_t clocking and the share of cycles clocked one by one show which tier the device can afford
+//
+// and with all output rates (CFG_AUDIO_RATE): the time per output sample relative to the sample period 
+// is the share of the emulation core's budget used at that rate (on this host)
+//
+// the second part compares SID16::render() (block rendering with time-stamped writes) to clocking
+// up to each write/sample and polling SID16::output(); both must produce identical output
+//
+// usage: skpico_bench [emulated seconds per configuration, default 10]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+#include <math.h>
+
+#include "reSID16/sid.h"
+#include "reSIDWrapper.h"
+#include "hostGlue.h"
+#include "synthTune.h"
+
+extern const volatile signed short filterLUT6581[ 20 * 2048 ];	// defined with reSIDWrapper.cc
+extern SID16 *sid16, *sid16b;
+
+struct BenchConfig
+{
+	const char *name;
+	uint8_t sid1Type, sid2Type, distortion;
+	SynthTuneType tune;
+};
+
+static const BenchConfig benchConfigs[] = {
+	{ "6581 single",            0, 3, 0, SYNTH_SINGLE },
+	{ "6581 single+distortion", 0, 3, 8, SYNTH_SINGLE },
+	{ "8580 single",            1, 3, 0, SYNTH_SINGLE },
+	{ "6581+8580 dual",         0, 1, 0, SYNTH_DUAL },
+	{ "6581+6581 dual+distort.",0, 0, 8, SYNTH_DUAL },
+	{ "8580+FM",                1, 3, 0, SYNTH_FM },
+};
+
+static const char *accuracyNames[ 3 ] = { "delta", "cycle", "hybrid" };
+
+// point sampling of the output at the sample clock, and band-limited output (SAMPLE_DECIMATE)
+static const sampling_method renderSampling[ 2 ] = { SAMPLE_INTERPOLATE, SAMPLE_DECIMATE };
+
+static const char *audioRateNames[ 3 ] = { "44.1kHz", "48kHz", "96kHz" };
+
+struct BenchResult
+{
+	uint64_t cycles, samples, checksum;
+	double   wall, exact;
+};
+
+static BenchResult runConfiguration( const BenchConfig &bc, int accuracy, int audioRate, int seconds, FM_OPL *pOPL, std::vector<SynthWrite> &tune )
+{
+	setDefaultConfiguration();
+	synthTuneConfiguration( bc.tune, config );
+	config[ CFG_SID1_TYPE ] = bc.sid1Type;
+	if ( bc.tune == SYNTH_DUAL )
+		config[ CFG_SID2_TYPE ] = bc.sid2Type;
+	config[ CFG_FILTER_6581_DISTORTION ] = bc.distortion;
+	config[ CFG_EMULATION_ACCURACY ] = accuracy;
+	config[ CFG_AUDIO_RATE ] = audioRate;
+	updateConfiguration();
+	// power-on state of the SIDs and the FM chip: each run is independent of the previous ones
+	resetReSID();
+	pOPL = ym3812_init( 3579545, AUDIO_RATE );
+
+	const uint64_t nCycles = (uint64_t)C64_CLOCK * seconds;
+	synthTune( tune, bc.tune, C64_CLOCK, nCycles );
+
+	uint64_t checksum = 0xcbf29ce484222325ull;
+	uint64_t cycle = 0, nSamples = 0;
+	size_t   next = 0;
+
+	#define EMULATE( n ) {	if ( FM_ENABLE ) emulateCyclesReSIDSingle( n ); else emulateCyclesReSID( n ); \
+							readRegs( &outRegisters[ 0x1b ], &outRegisters_2[ 0x1b ] ); }
+
+	auto t0 = std::chrono::steady_clock::now();
+
+	while ( cycle < nCycles )
+	{
+		uint64_t sampleCycle = ( nSamples + 1 ) * C64_CLOCK / AUDIO_RATE;
+
+		while ( next < tune.size() && tune[ next ].cycle < sampleCycle )
+		{
+			const SynthWrite &bw = tune[ next ++ ];
+			if ( bw.cycle > cycle )
+			{
+				EMULATE( bw.cycle - cycle );
+				cycle = bw.cycle;
+			}
+			if ( bw.chip == HOST_CHIP_FM )
+				ym3812_write( pOPL, ( bw.reg >> 4 ) & 1, bw.value ); else
+			if ( bw.chip == HOST_CHIP_SID2 )
+				writeReSID2( bw.reg, bw.value ); else
+				writeReSID( bw.reg, bw.value );
+		}
+
+		if ( sampleCycle > cycle )
+			EMULATE( sampleCycle - cycle );
+		cycle = sampleCycle;
+
+		int16_t L, R;
+		if ( FM_ENABLE )
+		{
+			OPLSAMPLE fm;
+			ym3812_update_one( pOPL, &fm, 1 );
+			outputReSIDFM( &L, &R, (int32_t)fm, 0, NULL );
+		} else
+			outputReSID( &L, &R );
+
+		checksum = ( checksum ^ (uint16_t)L ) * 0x100000001b3ull;
+		checksum = ( checksum ^ (uint16_t)R ) * 0x100000001b3ull;
+		nSamples ++;
+	}
+
+	#undef EMULATE
+
+	BenchResult r;
+	r.wall = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+	r.cycles = cycle;
+	r.samples = nSamples;
+	r.checksum = checksum;
+
+	// share of the emulated cycles (of both SIDs in dual-SID mode) clocked one by one
+	r.exact = (double)( sid16->cycles_exact + ( bc.tune == SYNTH_DUAL ? sid16b->cycles_exact : 0 ) ) / 
+			  (double)( cycle * ( bc.tune == SYNTH_DUAL ? 2 : 1 ) );
+	return r;
+}
+
+int main( int argc, char **argv )
+{
+	int seconds = argc > 1 ? atoi( argv[ 1 ] ) : 10;
+	if ( seconds < 1 ) seconds = 1;
+
+	setDefaultConfiguration();
+	initReSID();
+
+	FM_OPL *pOPL = ym3812_init( 3579545, AUDIO_RATE );
+
+	std::vector<SynthWrite> tune;
+
+	printf( "%-24s %-8s %14s %10s %10s %10s %8s %8s %18s\n", "configuration", "accuracy", "cycles", "wall [s]", "ns/cycle", "realtime", "cost", "exact", "checksum" );
+
+	for ( const BenchConfig &bc : benchConfigs )
+	{
+		double wallDelta = 0.0;
+		for ( int accuracy = ACCURACY_DELTA; accuracy <= ACCURACY_HYBRID; accuracy ++ )
+		{
+			BenchResult r = runConfiguration( bc, accuracy, 0, seconds, pOPL, tune );
+			if ( accuracy == ACCURACY_DELTA ) wallDelta = r.wall;
+
+			printf( "%-24s %-8s %14llu %10.3f %10.2f %9.1fx %7.2fx %7.1f%% %016llx\n", bc.name, accuracyNames[ accuracy ], (unsigned long long)r.cycles, r.wall, 
+					r.wall * 1e9 / (double)r.cycles, (double)r.cycles / (double)C64_CLOCK / r.wall, r.wall / wallDelta, 100.0 * r.exact, (unsigned long long)r.checksum );
+		}
+	}
+
+	//
+	// output rates: time per sample vs. the sample period
+	//
+	printf( "\n%-24s %-8s %12s %12s %10s %8s\n", "configuration", "rate", "samples", "ns/sample", "period", "budget" );
+
+	for ( const BenchConfig &bc : benchConfigs )
+	{
+		for ( int audioRate = 0; audioRate < 3; audioRate ++ )
+		{
+			BenchResult r = runConfiguration( bc, ACCURACY_DELTA, audioRate, seconds, pOPL, tune );
+			double nsPerSample = r.wall * 1e9 / (double)r.samples, period = 1e9 / (double)AUDIO_RATE;
+
+			printf( "%-24s %-8s %12llu %12.1f %10.1f %7.2f%%\n", bc.name, audioRateNames[ audioRate ], (unsigned long long)r.samples, 
+					nsPerSample, period, 100.0 * nsPerSample / period );
+		}
+	}
+
+	// back to the default rate for the remaining tests
+	config[ CFG_AUDIO_RATE ] = 0;
+	updateConfiguration();
+
+	//
+	// SID16::render() vs. clock()/output()
+	//
+	printf( "\n%-30s %12s %12s %18s\n", "SID16::render", "poll ns/cyc", "block ns/cyc", "checksum" );
+
+	int failed = 0;
+	static SID16 sidPoll, sidBlock;
+
+	for ( const BenchConfig &bc : benchConfigs )
+	{
+		if ( bc.tune != SYNTH_SINGLE )
+			continue;
+
+		for ( int sm = 0; sm < 2; sm++ )
+		{
+			SID16 *sids[ 2 ] = { &sidPoll, &sidBlock };
+			for ( SID16 *s : sids )
+			{
+				s->set_chip_model( bc.sid1Type ? MOS8580 : MOS6581 );
+				s->set_sampling_parameters( C64_CLOCK, renderSampling[ sm ], AUDIO_RATE );
+				s->reset();
+				s->filter.set6581FilterCoeffs( (signed short*)&filterLUT6581[ 0 ], 220, 1800, bc.distortion );
+			}
+
+			const uint64_t nCycles = (uint64_t)C64_CLOCK * seconds;
+			synthTune( tune, bc.tune, C64_CLOCK, nCycles );
+
+			// sample clock as in handleBus()
+			std::vector<uint64_t> sampleCycles;
+			for ( uint64_t c = 1, cur = 0; c <= nCycles; c++ )
+			{
+				cur += AUDIO_RATE;
+				if ( cur > C64_CLOCK ) { cur -= C64_CLOCK; sampleCycles.push_back( c ); }
+			}
+
+			// clocking up to each write and sample, polling the output
+			uint64_t checksumPoll = 0xcbf29ce484222325ull, cycle = 0;
+			size_t next = 0;
+			auto t0 = std::chrono::steady_clock::now();
+			for ( uint64_t sc : sampleCycles )
+			{
+				while ( next < tune.size() && tune[ next ].cycle <= sc )
+				{
+					if ( tune[ next ].cycle > cycle ) { sidPoll.clock( tune[ next ].cycle - cycle ); cycle = tune[ next ].cycle; }
+					sidPoll.write( tune[ next ].reg, tune[ next ].value );
+					next ++;
+				}
+				if ( sc > cycle ) { sidPoll.clock( sc - cycle ); cycle = sc; }
+				checksumPoll = ( checksumPoll ^ (uint16_t)sidPoll.output() ) * 0x100000001b3ull;
+			}
+			double wallPoll = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+
+			// blocks of 256 samples
+			const cycle_count blockCycles = 256 * C64_CLOCK / AUDIO_RATE;
+			std::vector<WriteEvent> events;
+			short out[ 512 ];
+			uint64_t checksumBlock = 0xcbf29ce484222325ull;
+			next = 0;
+			t0 = std::chrono::steady_clock::now();
+			for ( uint64_t block = 0; block < cycle; block += blockCycles )
+			{
+				cycle_count n = (cycle_count)std::min<uint64_t>( blockCycles, cycle - block );
+				events.clear();
+				while ( next < tune.size() && tune[ next ].cycle < block + n )
+				{
+					events.push_back( { (cycle_count)( tune[ next ].cycle - block ), tune[ next ].reg, tune[ next ].value } );
+					next ++;
+				}
+				int nSamples = sidBlock.render( n, events.data(), (int)events.size(), out, 512 );
+				for ( int i = 0; i < nSamples; i++ )
+					checksumBlock = ( checksumBlock ^ (uint16_t)out[ i ] ) * 0x100000001b3ull;
+			}
+			double wallBlock = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+
+			char name[ 64 ];
+			snprintf( name, 64, "%s%s", bc.name, sm ? " decim." : "" );
+			printf( "%-30s %12.2f %12.2f %016llx %s\n", name, wallPoll * 1e9 / (double)cycle, wallBlock * 1e9 / (double)cycle, 
+					(unsigned long long)checksumBlock, checksumBlock == checksumPoll ? "identical" : "MISMATCH" );
+			if ( checksumBlock != checksumPoll ) failed ++;
+		}
+	}
+
+	//
+	// aliasing of a bright sawtooth (3.5kHz, filter bypassed): power of the harmonics above the Nyquist 
+	// frequency folded back into the audio band, relative to the harmonics below, measured with the
+	// Goertzel algorithm (Hann window) at each folded frequency, for each output rate
+	//
+	printf( "\n%-30s %12s\n", "aliasing (sawtooth 3.5kHz)", "alias [dB]" );
+
+	for ( int audioRate = 0; audioRate < 3; audioRate ++ )
+	for ( int sm = 0; sm < 2; sm++ )
+	{
+		config[ CFG_AUDIO_RATE ] = audioRate;
+		updateConfiguration();
+
+		static SID16 sid;
+		sid.set_chip_model( MOS8580 );
+		sid.set_sampling_parameters( C64_CLOCK, renderSampling[ sm ], AUDIO_RATE );
+		sid.reset();
+
+		const reg16 freq = (reg16)( 3500.0 * 16777216.0 / C64_CLOCK );
+		const double f0 = freq * (double)C64_CLOCK / 16777216.0;
+		const uint8_t regs[][ 2 ] = { { 0x18, 0x0f }, { 0x05, 0x00 }, { 0x06, 0xf0 }, { 0x00, (uint8_t)( freq & 255 ) }, { 0x01, (uint8_t)( freq >> 8 ) }, { 0x04, 0x21 } };
+		for ( auto &r : regs )
+			sid.write( r[ 0 ], r[ 1 ] );
+
+		const int N = 32768, warmup = 4096;
+		std::vector<double> x;
+		for ( uint64_t c = 1, cur = 0, cycle = 0; x.size() < N; c++ )
+		{
+			cur += AUDIO_RATE;
+			if ( cur > C64_CLOCK )
+			{
+				cur -= C64_CLOCK;
+				sid.clock( (cycle_count)( c - cycle ) ); cycle = c;
+				if ( c > (uint64_t)warmup * C64_CLOCK / AUDIO_RATE )
+					x.push_back( sid.output() * ( 0.5 - 0.5 * cos( 2.0 * M_PI * x.size() / ( N - 1 ) ) ) );
+			}
+		}
+
+		auto goertzel = [&]( double f ) {
+			double w = 2.0 * cos( 2.0 * M_PI * f / AUDIO_RATE ), s1 = 0, s2 = 0;
+			for ( double v : x ) { double s0 = v + w * s1 - s2; s2 = s1; s1 = s0; }
+			return s1 * s1 + s2 * s2 - w * s1 * s2;
+		};
+
+		double signal = 0, alias = 0;
+		for ( int h = 1; h * f0 < C64_CLOCK / 2; h++ )
+		{
+			double f = fmod( h * f0, (double)AUDIO_RATE );
+			if ( f > AUDIO_RATE / 2 ) f = AUDIO_RATE - f;
+			if ( h * f0 < AUDIO_RATE / 2 ) { signal += goertzel( f ); continue; }
+			// skip aliases on top of (or next to) a harmonic
+			double d = fmod( f, f0 );
+			if ( d < 10.0 || f0 - d < 10.0 ) continue;
+			alias += goertzel( f );
+		}
+
+		char name[ 64 ];
+		snprintf( name, 64, "8580 %s%s", audioRateNames[ audioRate ], sm ? " decim." : "" );
+		printf( "%-30s %12.1f\n", name, 10.0 * log10( alias / signal ) );
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,380 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  skpico_busmodel.cc
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// runs the firmware's handleBus() on the virtual C64 bus (busModel.h) through a sequence of scenarios
+// covering its state machines, one session as on a real C64:
+//
+//   SID writes      commands and time stamps in the ring, bus value on reads of write-only registers and its decay
+//   autodetect      the model detection sequence ($d40e/$d40f/$d412, read of $d41b)
+//   config mode     reading the configuration and the version string, leaving config mode after the timeout
+//   SID #2          $d420 (A8 wire) and $de00 (IO1 wire) after changing the configuration via $d41d/$d41e
+//   PRG upload      directory entry and the flash writes for a slot
+//   reset           flushed ring, restarted time stamps and the request to the emulation core
+//   launcher        a 6502 executing JMP $d41d: launcher and config tool transferred into the C64's RAM
+//
+// usage: skpico_busmodel [-v]
+//
+// all half-cycles are also checked for the data lines being driven when the CPU is not reading from the
+// SIDKick. A failure makes the exit code non-zero.
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "busModel.h"
+
+static uint32_t nErrors = 0;
+static int verbose = 0;
+
+static void check( bool ok, const char *fmt, ... )
+{
+	if ( ok ) return;
+	if ( nErrors ++ < 20 )
+	{
+		va_list args;
+		va_start( args, fmt );
+		printf( "  " );
+		vprintf( fmt, args );
+		printf( "\n" );
+		va_end( args );
+	}
+}
+
+static int  busRead( uint16_t addr ) { return busModelCycle( addr, 0, 0 ); }
+static void busWrite( uint16_t addr, uint8_t data ) { busModelCycle( addr, 1, data ); }
+
+struct Command { uint16_t cmd; uint32_t time; };
+
+static uint32_t popCommands( Command *c, uint32_t n )
+{
+	uint16_t cmd[ 256 ];
+	uint32_t time[ 256 ];
+	uint32_t m = busModelPopCommands( cmd, time, n < 256 ? n : 256 );
+	for ( uint32_t i = 0; i < m; i ++ )
+		c[ i ] = { cmd[ i ], time[ i ] };
+	return m;
+}
+
+static void scenario( const char *name )
+{
+	if ( verbose )
+		printf( "%-12s (cycle %u, %u errors so far)\n", name, busModelCycles(), nErrors );
+}
+
+//
+// config mode, writes of config[ 0.. ] as the config tool does them (the index always starts at 0)
+//
+static void enterConfigMode()
+{
+	busWrite( 0xd41f, 0xff );
+}
+
+static void writeConfig( const uint8_t *values, int n, uint8_t commit )
+{
+	enterConfigMode();
+	busWrite( 0xd41e, 0 );
+	for ( int i = 0; i < n; i ++ )
+		busWrite( 0xd41d, values[ i ] );
+	busWrite( 0xd41d, commit );
+	busModelIdle( 2 );
+}
+
+//
+// 6502 for the launcher: the opcodes of the transfer loop, with the dummy reads the firmware relies on
+//
+struct CPU6502
+{
+	uint16_t pc = 0;
+	uint8_t  a = 0, s = 0xff;
+	uint8_t  ram[ 65536 ];
+
+	uint8_t read( uint16_t addr )
+	{
+		int d = busRead( addr );
+		return d >= 0 ? d : ram[ addr ];
+	}
+
+	void write( uint16_t addr, uint8_t d )
+	{
+		busWrite( addr, d );
+		if ( addr < 0xd000 || addr >= 0xe000 )
+			ram[ addr ] = d;
+	}
+
+	bool step()
+	{
+		uint16_t t;
+		switch ( read( pc ++ ) )
+		{
+		case 0x78: read( pc ); break;										// SEI
+		case 0x48: read( pc ); write( 0x100 + s --, a ); break;			// PHA
+		case 0x68: read( pc ); read( 0x100 + s ); a = read( 0x100 + ++ s ); break;	// PLA
+		case 0xa9: a = read( pc ++ ); break;								// LDA #
+		case 0x8d: t = read( pc ++ ); t |= read( pc ++ ) << 8; write( t, a ); break;	// STA abs
+		case 0x4c: t = read( pc ++ ); t |= read( pc ) << 8; pc = t; break;	// JMP abs
+		default: return false;
+		}
+		return true;
+	}
+};
+
+int main( int argc, char **argv )
+{
+	for ( int i = 1; i < argc; i ++ )
+	{
+		if ( !strcmp( argv[ i ], "-v" ) )
+			verbose = 1; else
+		{
+			printf( "usage: %s [-v]\n", argv[ 0 ] );
+			return 1;
+		}
+	}
+
+	busModelStart();
+	busModelIdle( 100 );
+
+	Command c[ 256 ];
+	uint32_t n;
+
+	//
+	// SID writes
+	//
+	scenario( "SID writes" );
+	popCommands( c, 256 );
+	busWrite( 0xd400, 0x11 );
+	busModelIdle( 5 );
+	busWrite( 0xd401, 0x22 );
+	busModelIdle( 100 );
+	busWrite( 0xd418, 0x0f );
+
+	n = popCommands( c, 256 );
+	check( n == 3, "SID writes: %u commands, expected 3", n );
+	if ( n == 3 )
+	{
+		check( c[ 0 ].cmd == 0x0011 && c[ 1 ].cmd == 0x0122 && c[ 2 ].cmd == 0x180f, "SID writes: commands %04x %04x %04x", c[ 0 ].cmd, c[ 1 ].cmd, c[ 2 ].cmd );
+		check( c[ 1 ].time - c[ 0 ].time == 6 && c[ 2 ].time - c[ 1 ].time == 101, "SID writes: time stamps %u %u %u", c[ 0 ].time, c[ 1 ].time, c[ 2 ].time );
+	}
+
+	int d = busRead( 0xd405 );
+	check( d == 0x0f, "bus value: read of $d405 gave %d, expected $0f", d );
+	busModelIdle( 0x100000 + 2 );
+	d = busRead( 0xd405 );
+	check( d == 0, "bus value: read of $d405 gave %d after decay, expected 0", d );
+
+	//
+	// model detection
+	//
+	scenario( "autodetect" );
+	busWrite( 0xd40e, 0xff );
+	busWrite( 0xd40f, 0xff );
+	busWrite( 0xd412, 0xff );
+	busWrite( 0xd412, 0x20 );
+	d = busRead( 0xd41b );
+	int expected = config[ 0 ] == 0 ? 3 : 2;
+	check( d == expected, "autodetect: $d41b gave %d, expected %d", d, expected );
+	popCommands( c, 256 );
+
+	//
+	// config mode
+	//
+	scenario( "config mode" );
+	enterConfigMode();
+	busWrite( 0xd41e, 0 );
+	uint32_t nDiffer = 0;
+	for ( int i = 0; i < 64; i ++ )
+		nDiffer += busRead( 0xd41d ) != config[ i ];
+	check( nDiffer == 0, "config mode: %u configuration bytes differ", nDiffer );
+
+	// the version string is read byte by byte, each one selected via $d41e
+	uint8_t version[ 2 ];
+	for ( int i = 0; i < 2; i ++ )
+	{
+		busWrite( 0xd41e, 224 + i );
+		version[ i ] = busRead( 0xd41d );
+	}
+	check( version[ 0 ] == 'S' && version[ 1 ] == 'K', "config mode: version string starts with %02x %02x", version[ 0 ], version[ 1 ] );
+
+	// back at the start of the version string: 'S' in config mode, the first byte of JMP $d400 after it
+	busWrite( 0xd41e, 224 );
+	busModelIdle( 25000 + 1 );
+	d = busRead( 0xd41d );
+	check( d == 0x4c, "config mode: not left after the timeout ($d41d gave %d)", d );
+	busWrite( 0xd418, 0x0f );
+
+	n = popCommands( c, 256 );
+	check( n == 1 && c[ 0 ].cmd == 0x180f, "config mode: %u commands, expected only the write after it", n );
+
+	//
+	// SID #2: $d420 on the A8 wire, $de00 on the IO1 wire
+	//
+	scenario( "SID #2" );
+	uint8_t cfg[ 11 ], cfgBefore[ 11 ];
+	memcpy( cfgBefore, config, 11 );
+	memcpy( cfg, config, 11 );
+	cfg[ 8 ] = 1;
+	cfg[ 10 ] = 1;
+	writeConfig( cfg, 11, 0xfe );
+	check( config[ 10 ] == 1, "SID #2: configuration not written" );
+	popCommands( c, 256 );
+
+	busWrite( 0xd420 + 5, 0x33 );
+	busWrite( 0xd400 + 5, 0x44 );
+	busWrite( 0xd500 + 5, 0x55 );
+	n = popCommands( c, 256 );
+	check( n == 3 && c[ 0 ].cmd == 0x8533 && c[ 1 ].cmd == 0x0544 && c[ 2 ].cmd == 0x0555,
+		   "SID #2 at $d420: %u commands %04x %04x %04x", n, c[ 0 ].cmd, c[ 1 ].cmd, c[ 2 ].cmd );
+
+	// rewired before: with SID #2 in the IO area, the firmware takes A8 low as an access
+	cfg[ 10 ] = 4;
+	busModelSetWire( BUS_WIRE_IO1 );
+	writeConfig( cfg, 11, 0xfe );
+	popCommands( c, 256 );
+
+	busWrite( 0xde00 + 5, 0x66 );
+	busWrite( 0xd400 + 5, 0x77 );
+	d = busRead( 0xdf00 + 5 );
+	check( d < 0, "SID #2 at $de00: read of $df05 answered" );
+	n = popCommands( c, 256 );
+	check( n == 2 && c[ 0 ].cmd == 0x8566 && c[ 1 ].cmd == 0x0577,
+		   "SID #2 at $de00: %u commands %04x %04x", n, c[ 0 ].cmd, c[ 1 ].cmd );
+
+	writeConfig( cfgBefore, 11, 0xfe );
+	busModelSetWire( BUS_WIRE_A8 );
+	popCommands( c, 256 );
+
+	//
+	// PRG upload to slot 3: load address, data, 18 bytes menu entry
+	//
+	scenario( "PRG upload" );
+	const uint8_t slot = 3;
+	const int nData = 300;
+	uint8_t prg[ 2 + nData + 18 ];
+	for ( int i = 0; i < 2 + nData; i ++ )
+		prg[ i ] = (uint8_t)( i * 7 + 3 );
+	memcpy( &prg[ 2 + nData ], "BUS MODEL TEST PRG", 18 );
+
+	uint32_t nFlashOps = busModelNumFlashOps;
+	enterConfigMode();
+	busWrite( 0xd41a, slot );
+	busWrite( 0xd419, 0 );
+	for ( int i = 0; i < 256; i ++ )
+		busWrite( 0xd416, prg[ i ] );
+	busWrite( 0xd419, 1 );
+	for ( int i = 256; i < (int)sizeof( prg ); i ++ )
+		busWrite( 0xd416, prg[ i ] );
+	busWrite( 0xd417, 0 );
+	busModelIdle( 2 );
+
+	const uint8_t *dirEntry = &prgDirectory[ slot * 24 ];
+	check( !memcmp( dirEntry, &prg[ 2 + nData ], 18 ) && dirEntry[ 20 ] == slot && dirEntry[ 22 ] + dirEntry[ 23 ] * 256 == 2 + nData,
+		   "PRG upload: directory entry" );
+
+	check( busModelNumFlashOps - nFlashOps == 4, "PRG upload: %u flash operations, expected 4", busModelNumFlashOps - nFlashOps );
+	if ( busModelNumFlashOps - nFlashOps == 4 )
+	{
+		const BUS_FLASH_OP *f = &busModelFlashOps[ nFlashOps ];
+		uint32_t ofsDir = busModelFlashOffset( prgDirectory_Flash ), ofsPRG = busModelFlashOffset( &prgRepository[ slot * 65536 ] );
+
+		check( f[ 0 ].op == BUS_FLASH_ERASE && f[ 0 ].offset == ofsDir && f[ 1 ].op == BUS_FLASH_PROGRAM && f[ 1 ].offset == ofsDir,
+			   "PRG upload: directory not written to flash" );
+		check( f[ 1 ].dataSize >= ( slot + 1 ) * 24u && !memcmp( &f[ 1 ].data[ slot * 24 ], dirEntry, 24 ), "PRG upload: directory entry written to flash differs" );
+
+		check( f[ 2 ].op == BUS_FLASH_ERASE && f[ 2 ].offset == ofsPRG && f[ 2 ].size == 65536 &&
+			   f[ 3 ].op == BUS_FLASH_PROGRAM && f[ 3 ].offset == ofsPRG && f[ 3 ].size == 65536,
+			   "PRG upload: PRG not written to slot %u", slot );
+		check( f[ 3 ].dataSize >= 2 + nData && f[ 3 ].data[ 0 ] == 0x01 && f[ 3 ].data[ 1 ] == 0x08 && !memcmp( &f[ 3 ].data[ 2 ], &prg[ 2 ], nData ),
+			   "PRG upload: PRG written to flash differs" );
+	}
+
+	//
+	// reset
+	//
+	scenario( "reset" );
+	busWrite( 0xd404, 0x41 );			// discarded by the reset
+	busModelLastReset = 0;
+	busModelSetReset( 1 );
+	busModelIdle( 3000 );
+	busModelSetReset( 0 );
+	busModelIdle( 2 );
+	check( busModelLastReset == 1, "reset: request %u to the emulation core, expected 1", busModelLastReset );
+
+	d = busRead( 0xd405 );
+	check( d == 0, "reset: bus value %d, expected 0", d );
+	busWrite( 0xd401, 0x99 );
+	n = popCommands( c, 256 );
+	check( n == 1 && c[ 0 ].cmd == 0x0199 && c[ 0 ].time < 10, "reset: %u commands, first %04x at %u", n, c[ 0 ].cmd, c[ 0 ].time );
+
+	//
+	// launcher and config tool via JMP $d41d
+	//
+	scenario( "launcher" );
+	static CPU6502 cpu;
+	memset( cpu.ram, 0, sizeof( cpu.ram ) );
+	cpu.ram[ 0xc000 ] = 0x4c;
+	cpu.ram[ 0xc001 ] = 0x1d;
+	cpu.ram[ 0xc002 ] = 0xd4;
+	cpu.pc = 0xc000;
+
+	busWrite( 0xd418, 0x0f );
+	uint16_t launcherAddress = launchCode[ 0 ] + launchCode[ 1 ] * 256;
+	uint32_t start = busModelCycles();
+	while ( cpu.pc != launcherAddress && busModelCycles() - start < 2000000 )
+	{
+		if ( !cpu.step() )
+		{
+			check( false, "launcher: unexpected opcode at $%04x", cpu.pc - 1 );
+			break;
+		}
+	}
+	check( cpu.pc == launcherAddress, "launcher: not started (PC $%04x)", cpu.pc );
+
+	check( !memcmp( &cpu.ram[ launcherAddress ], &launchCode[ 2 ], launchSize - 2 ), "launcher: code in RAM differs" );
+
+	uint16_t loadAddress = prgCode[ 0 ] + prgCode[ 1 ] * 256;
+	check( !memcmp( &cpu.ram[ loadAddress ], &prgCode[ 2 ], prgCode_size - 2 ), "launcher: config tool in RAM differs" );
+
+	busWrite( 0xd400, 0x12 );
+	n = popCommands( c, 256 );
+	check( n >= 1 && c[ n - 1 ].cmd == 0x0012, "launcher: no SID communication after the transfer" );
+
+	if ( verbose )
+		printf( "%u cycles\n", busModelCycles() );
+
+	busModelStop();
+
+	if ( busModelContention )
+	{
+		printf( "  data lines driven in %u half-cycles not reading from the SIDKick\n", busModelContention );
+		nErrors ++;
+	}
+
+	printf( nErrors ? "FAILED: %u errors\n" : "passed\n", nErrors );
+	return nErrors ? 1 : 0;
+}
@@ -0,0 +1,573 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  skpico_kernels.cc
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// microbenchmarks of the reSID16 and fmopl inner kernels, each one isolated and clocked with 
+// the delta_t distribution observed when replaying tunes through the emulation core (on the 
+// device the emulation core clocks reSID in small, irregular steps, not once per sample)
+//
+// usage: skpico_kernels [-t trace.sktr]... [-n calls per kernel] [-d drain interval]
+//
+// without traces, the built-in synthetic tunes (single, digi, fm) provide the delta_t distribution,
+// the drain interval (C64 cycles between emulation calls during replay) shapes it further
+//
+// finally the DSP-extension kernels (reSID16/dsp.h, SSAT/USAT/SMLAD on the RP2350) are checked 
+// against their plain C references for bit-exactness, on random and extreme inputs, and the OSC3/ENV3
+// lookahead of the bus core (SID16::predictVoice3()) against the chip clocked in the same steps, and
+// DualSID16 against two SID16 clocked one after the other; a mismatch is reported and makes the exit
+// code non-zero
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "reSID16/sid.h"
+#include "reSIDWrapper.h"
+#include "hostGlue.h"
+#include "traceReplay.h"
+
+extern "C" void OPL_CALC_CH( OPL_CH *CH );
+extern const volatile signed short filterLUT6581[ 20 * 2048 ];	// defined with reSIDWrapper.cc
+
+// gives access to the voice's waveform and envelope generator
+struct BenchVoice : public Voice
+{
+	WaveformGenerator &w() { return wave; }
+	EnvelopeGenerator &e() { return envelope; }
+};
+
+static std::vector<int> deltas;		// sequence of delta_t following the observed distribution
+static uint64_t deltaCycles;		// sum of all deltas
+static volatile int sink;
+
+static void buildDeltaSequence( const uint32_t *hist, int n )
+{
+	uint64_t total = 0;
+	for ( int i = 0; i < HOST_DELTA_HISTOGRAM_SIZE; i++ )
+		total += hist[ i ];
+
+	// deterministic draw via inverse CDF
+	uint32_t lcg = 0x5eed;
+	deltas.resize( n );
+	deltaCycles = 0;
+	for ( int i = 0; i < n; i++ )
+	{
+		lcg = lcg * 1664525u + 1013904223u;
+		uint64_t r = (uint64_t)( lcg >> 8 ) * total >> 24;
+		int d = 1;
+		uint64_t acc = 0;
+		for ( d = 1; d < HOST_DELTA_HISTOGRAM_SIZE - 1; d++ )
+		{
+			acc += hist[ d ];
+			if ( acc > r ) break;
+		}
+		deltas[ i ] = d;
+		deltaCycles += d;
+	}
+}
+
+static void printDistribution( const uint32_t *hist )
+{
+	uint64_t total = 0, sum = 0;
+	for ( int i = 0; i < HOST_DELTA_HISTOGRAM_SIZE; i++ )
+	{
+		total += hist[ i ];
+		sum += (uint64_t)hist[ i ] * i;
+	}
+
+	int pct[ 4 ] = { 50, 90, 99, 100 }, val[ 4 ] = { 0 };
+	for ( int p = 0; p < 4; p++ )
+	{
+		uint64_t acc = 0;
+		for ( int i = 0; i < HOST_DELTA_HISTOGRAM_SIZE; i++ )
+		{
+			acc += hist[ i ];
+			if ( acc * 100 >= total * pct[ p ] ) { val[ p ] = i; break; }
+		}
+	}
+
+	printf( "delta_t per reSID call: %llu calls, mean %.2f, median %d, p90 %d, p99 %d, max %d%s\n\n", 
+			(unsigned long long)total, (double)sum / (double)total, val[ 0 ], val[ 1 ], val[ 2 ], val[ 3 ],
+			val[ 3 ] == HOST_DELTA_HISTOGRAM_SIZE - 1 ? "+" : "" );
+}
+
+static double reference = 0.0;
+
+// dtScale stretches the delta_t sequence, e.g. for clocking only from register write to register write
+template<typename F>
+static void bench( const char *name, int perCall, F kernel, int dtScale = 1 )
+{
+	// warm up, then measure
+	for ( size_t i = 0; i < deltas.size() / 16; i++ )
+		kernel( deltas[ i ] * dtScale, i );
+
+	auto t0 = std::chrono::steady_clock::now();
+	for ( size_t i = 0; i < deltas.size(); i++ )
+		kernel( deltas[ i ] * dtScale, i );
+	double ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - t0 ).count();
+
+	double nsPerCycle = ns / (double)( deltaCycles * dtScale );
+	if ( reference == 0.0 ) reference = nsPerCycle;
+
+	printf( "%-40s %10.2f %12.3f %8.1f%%\n", name, ns / (double)( deltas.size() * perCall ), nsPerCycle / perCall, 100.0 * nsPerCycle / reference );
+}
+
+int main( int argc, char **argv )
+{
+	int nCalls = 1 << 20;
+	int drainInterval = 8;
+	std::vector<const char *> traceFiles;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[ i ], "-t" ) == 0 && i + 1 < argc ) traceFiles.push_back( argv[ ++ i ] ); else
+		if ( strcmp( argv[ i ], "-n" ) == 0 && i + 1 < argc ) nCalls = atoi( argv[ ++ i ] ); else
+		if ( strcmp( argv[ i ], "-d" ) == 0 && i + 1 < argc ) drainInterval = atoi( argv[ ++ i ] ); else
+		{
+			fprintf( stderr, "usage: skpico_kernels [-t trace.sktr]... [-n calls per kernel] [-d drain interval]\n" );
+			return 1;
+		}
+	}
+	if ( nCalls < 1024 ) nCalls = 1024;
+
+	//
+	// delta_t distribution from replaying tunes
+	//
+	static uint32_t hist[ HOST_DELTA_HISTOGRAM_SIZE ];
+	hostDeltaHistogram = hist;
+
+	BUSTRACE_HEADER header;
+	std::vector<BUSTRACE_EVENT> events;
+	ReplayResult res;
+
+	if ( traceFiles.empty() )
+	{
+		const SynthTuneType types[ 3 ] = { SYNTH_SINGLE, SYNTH_DIGI, SYNTH_FM };
+		for ( SynthTuneType t : types )
+		{
+			setDefaultConfiguration();
+			synthTuneConfiguration( t, config );
+			initReSID();
+			std::vector<SynthWrite> writes;
+			uint64_t nCycles = (uint64_t)C64_CLOCK * 4;
+			synthTune( writes, t, C64_CLOCK, nCycles );
+			encodeBusTrace( writes, nCycles, events );
+			replayBusTrace( events, drainInterval, NULL, res );
+		}
+	} else
+		for ( const char *fn : traceFiles )
+		{
+			if ( !loadBusTrace( fn, header, events ) )
+			{
+				fprintf( stderr, "error reading '%s'\n", fn );
+				return 1;
+			}
+			setDefaultConfiguration();
+			memcpy( config, header.config, 64 );
+			initReSID();
+			replayBusTrace( events, drainInterval, NULL, res );
+		}
+
+	hostDeltaHistogram = NULL;
+	printDistribution( hist );
+	buildDeltaSequence( hist, nCalls );
+
+	printf( "%-40s %10s %12s %9s\n", "kernel", "ns/call", "ns/cycle", "vs. SID" );
+
+	//
+	// complete SID as reference: 6581 with distortion, three voices, filter and external filter
+	//
+	{
+		static SID16 sid;
+		sid.set_chip_model( MOS6581 );
+		sid.reset();
+		sid.filter.set6581FilterCoeffs( (signed short*)&filterLUT6581[ 0 ], 220, 1800, 8 );
+		const uint8_t regs[] = { 0x00, 0x20, 0x01, 0x08, 0x02, 0x00, 0x03, 0x08, 0x05, 0x09, 0x06, 0xf0, 0x04, 0x21,
+								 0x07, 0x30, 0x08, 0x0c, 0x09, 0x00, 0x0a, 0x04, 0x0c, 0x0a, 0x0d, 0xa0, 0x0b, 0x41,
+								 0x0e, 0x00, 0x0f, 0x30, 0x13, 0x00, 0x14, 0xf0, 0x12, 0x81,
+								 0x15, 0x03, 0x16, 0x40, 0x17, 0xf3, 0x18, 0x1f };
+		for ( size_t i = 0; i < sizeof( regs ); i += 2 )
+			sid.write( regs[ i ], regs[ i + 1 ] );
+
+		bench( "SID16::clock (6581, distortion)", 1, [&]( int dt, size_t ) { sid.clock( dt ); } );
+
+		// dual SID (6581+6581, distortion), the second chip plays the voices an octave lower:
+		// two chips clocked one after the other vs. DualSID16 interleaving both
+		static SID16 sidb;
+		static DualSID16 dual;
+		auto setup = [&]( SID16 &s, bool lower ) {
+			s.set_chip_model( MOS6581 );
+			s.reset();
+			s.filter.set6581FilterCoeffs( (signed short*)&filterLUT6581[ 0 ], 220, 1800, 8 );
+			for ( size_t i = 0; i < sizeof( regs ); i += 2 )
+				s.write( regs[ i ], ( lower && regs[ i ] < 0x15 && regs[ i ] % 7 == 1 ) ? regs[ i + 1 ] >> 1 : regs[ i + 1 ] );
+		};
+		setup( sid, false );
+		setup( sidb, true );
+		setup( dual.sid[ 0 ], false );
+		setup( dual.sid[ 1 ], true );
+
+		bench( "SID16::clock x2 (6581+6581, distortion)", 2, [&]( int dt, size_t ) { sid.clock( dt ); sidb.clock( dt ); } );
+		bench( "DualSID16::clock (6581+6581, distortion)", 2, [&]( int dt, size_t ) { dual.clock( dt ); } );
+	}
+
+	//
+	// waveform generators
+	//
+	{
+		static WaveformGenerator wave[ 3 ];
+		for ( int i = 0; i < 3; i++ )
+		{
+			wave[ i ].set_chip_model( MOS6581 );
+			wave[ i ].set_sync_source( &wave[ ( i + 2 ) % 3 ] );
+			wave[ i ].reset();
+			wave[ i ].writeFREQ_LO( 0x37 * ( i + 1 ) );
+			wave[ i ].writeFREQ_HI( 0x09 * ( i + 1 ) );
+			wave[ i ].writePW_HI( 0x08 );
+		}
+		wave[ 0 ].writeCONTROL_REG( 0x20 );
+		wave[ 1 ].writeCONTROL_REG( 0x40 );
+		wave[ 2 ].writeCONTROL_REG( 0x10 );
+
+		bench( "WaveformGenerator::clock (saw/pulse/tri)", 3, [&]( int dt, size_t ) {
+			wave[ 0 ].clock( dt ); wave[ 1 ].clock( dt ); wave[ 2 ].clock( dt ); } );
+
+		bench( "WaveformGenerator::set_waveform_output", 3, [&]( int dt, size_t ) {
+			wave[ 0 ].clock( dt ); wave[ 0 ].set_waveform_output( dt );
+			wave[ 1 ].set_waveform_output( dt ); wave[ 2 ].set_waveform_output( dt ); } );
+
+		static WaveformGenerator noise;
+		noise.set_chip_model( MOS6581 );
+		noise.set_sync_source( &noise );
+		noise.reset();
+		noise.writeFREQ_LO( 0x00 );
+		noise.writeFREQ_HI( 0x40 );
+		noise.writeCONTROL_REG( 0x80 );
+
+		bench( "WaveformGenerator::clock (noise)", 1, [&]( int dt, size_t ) { noise.clock( dt ); } );
+
+		// hi-hat like noise: several shift register clocks per call
+		noise.writeFREQ_LO( 0xff );
+		noise.writeFREQ_HI( 0xff );
+		bench( "WaveformGenerator::clock (noise, high)", 1, [&]( int dt, size_t ) { noise.clock( dt ); } );
+	}
+
+	//
+	// envelope generators: gates toggled regularly to go through all states
+	//
+	{
+		static EnvelopeGenerator env[ 3 ];
+		for ( int i = 0; i < 3; i++ )
+		{
+			env[ i ].set_chip_model( MOS6581 );
+			env[ i ].reset();
+			env[ i ].writeATTACK_DECAY( 0x25 + i * 0x30 );
+			env[ i ].writeSUSTAIN_RELEASE( 0x8a - i * 0x22 );
+		}
+		auto runEnvelopes = [&]( int dt, size_t i ) {
+			if ( ( i & 8191 ) == 0 )
+			{
+				reg8 gate = ( i >> 13 ) & 1;
+				env[ 0 ].writeCONTROL_REG( gate ); env[ 1 ].writeCONTROL_REG( gate ); env[ 2 ].writeCONTROL_REG( gate );
+			}
+			env[ 0 ].clock( dt ); env[ 1 ].clock( dt ); env[ 2 ].clock( dt ); };
+		bench( "EnvelopeGenerator::clock", 3, runEnvelopes );
+		// sparse writes: clocked in long spans, decay/release are fast-forwarded over many rate periods
+		bench( "EnvelopeGenerator::clock (delta_t x1024)", 3, runEnvelopes, 1024 );
+	}
+
+	//
+	// voice output: snapshots of voices at different states
+	//
+	{
+		static BenchVoice voices[ 256 ], v;
+		v.set_chip_model( MOS6581 );
+		v.reset();
+		v.w().writeFREQ_HI( 0x1c );
+		v.w().writePW_HI( 0x06 );
+		v.e().writeATTACK_DECAY( 0x08 );
+		v.e().writeSUSTAIN_RELEASE( 0x84 );
+		v.writeCONTROL_REG( 0x41 );
+		for ( int i = 0; i < 256 * 64; i++ )
+		{
+			v.w().clock( 7 ); v.w().set_waveform_output( 7 ); v.e().clock( 7 );
+			if ( ( i & 63 ) == 0 ) voices[ i >> 6 ] = v;
+		}
+
+		int acc = 0;
+		bench( "Voice::output", 3, [&]( int, size_t i ) {
+			acc += voices[ i & 255 ].output() + voices[ ( i + 85 ) & 255 ].output() + voices[ ( i + 170 ) & 255 ].output(); } );
+		sink = acc;
+	}
+
+	//
+	// filters, fed with recorded voice output
+	//
+	{
+		static int voiceOut[ 4096 ];
+		{
+			static BenchVoice v;
+			v.set_chip_model( MOS6581 );
+			v.reset();
+			v.w().writeFREQ_HI( 0x0c );
+			v.e().writeATTACK_DECAY( 0x00 );
+			v.e().writeSUSTAIN_RELEASE( 0xf0 );
+			v.writeCONTROL_REG( 0x21 );
+			for ( int i = 0; i < 4096; i++ )
+			{
+				v.w().clock( 11 ); v.w().set_waveform_output( 11 ); v.e().clock( 11 );
+				voiceOut[ i ] = v.output();
+			}
+		}
+
+		static Filter filter;
+		auto setupFilter = [&]( chip_model model, int distortion ) {
+			filter.set_chip_model( model );
+			filter.reset();
+			filter.set6581FilterCoeffs( (signed short*)&filterLUT6581[ 0 ], 220, 1800, distortion );
+			filter.set8580FilterCoeffs( 0, 6200 );
+			filter.writeFC_LO( 0x03 );
+			filter.writeFC_HI( 0x40 );
+			filter.writeRES_FILT( 0xf3 );
+			filter.writeMODE_VOL( 0x1f );
+		};
+		auto runFilter = [&]( int dt, size_t i ) {
+			if ( ( i & 1023 ) == 0 ) filter.writeFC_HI( ( i >> 10 ) & 255 );
+			filter.clock( dt, voiceOut[ i & 4095 ], voiceOut[ ( i + 1365 ) & 4095 ], voiceOut[ ( i + 2730 ) & 4095 ], 0 ); };
+
+		setupFilter( MOS6581, 8 );
+		bench( "Filter::clock (6581, distortion)", 1, runFilter );
+		setupFilter( MOS6581, 0 );
+		bench( "Filter::clock (6581)", 1, runFilter );
+		setupFilter( MOS8580, 0 );
+		bench( "Filter::clock (8580)", 1, runFilter );
+		sink = filter.output();
+
+		static ExternalFilter extfilt;
+		extfilt.set_chip_model( MOS6581 );
+		extfilt.reset();
+		extfilt.setCutoffFrequencies( 10, 17000 );
+		extfilt.enable_filter( true );
+		bench( "ExternalFilter::clock", 1, [&]( int dt, size_t i ) { extfilt.clock( dt, voiceOut[ i & 4095 ] ); } );
+		sink = extfilt.output();
+	}
+
+	//
+	// OPL: channel calculation, and complete sample generation (for comparison, per call = per sample)
+	//
+	{
+		FM_OPL *pOPL = ym3812_init( 3579545, AUDIO_RATE );
+		const uint8_t regs[] = { 0x01, 0x20, 0x20, 0x21, 0x23, 0x21, 0x40, 0x18, 0x43, 0x00, 0x60, 0xf4, 0x63, 0xf4, 
+								 0x80, 0x36, 0x83, 0x36, 0xc0, 0x0e, 0xa0, 0x98, 0xb0, 0x31 };
+		for ( size_t i = 0; i < sizeof( regs ); i += 2 )
+		{
+			ym3812_write( pOPL, 0, regs[ i ] );
+			ym3812_write( pOPL, 1, regs[ i + 1 ] );
+		}
+		OPLSAMPLE s;
+		for ( int i = 0; i < 1000; i++ )
+			ym3812_update_one( pOPL, &s, 1 );
+
+		printf( "\n%-40s %10s\n", "FM kernel (per sample, not per cycle)", "ns/call" );
+		auto t0 = std::chrono::steady_clock::now();
+		for ( size_t i = 0; i < deltas.size(); i++ )
+			OPL_CALC_CH( &pOPL->P_CH[ 0 ] );
+		double ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - t0 ).count();
+		printf( "%-40s %10.2f\n", "OPL_CALC_CH", ns / (double)deltas.size() );
+
+		t0 = std::chrono::steady_clock::now();
+		for ( size_t i = 0; i < deltas.size(); i++ )
+			ym3812_update_one( pOPL, &s, 1 );
+		ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - t0 ).count();
+		printf( "%-40s %10.2f\n", "ym3812_update_one (9 channels)", ns / (double)deltas.size() );
+		sink = s;
+	}
+
+	//
+	// DSP kernels vs. references
+	//
+	printf( "\n%-40s %10s\n", "DSP kernel (reSID16/dsp.h)", "result" );
+
+	uint32_t lcg = 0xd5b;
+	auto rnd = [&]() { lcg = lcg * 1664525u + 1013904223u; return lcg; };
+	// random values, with a bias towards the extremes of the type
+	auto rndShort = [&]() { uint32_t r = rnd(); return ( r & 3 ) ? (short)( r >> 16 ) : ( ( r & 4 ) ? (short)32767 : (short)-32768 ); };
+
+	int failed = 0;
+	auto report = [&]( const char *name, uint64_t errors ) {
+		printf( "%-40s %10s\n", name, errors ? "MISMATCH" : "identical" );
+		if ( errors ) failed ++;
+	};
+
+	{
+		uint64_t errors = 0;
+		const int edges[] = { 0, -1, 65535, 65536, -65536, -65537, 32767 << 16, ( 32767 << 16 ) + 65535, -32767 * 65536, -32767 * 65536 - 1, 
+							  -32768 * 65536, INT32_MAX, INT32_MIN };
+		for ( int x : edges )
+			errors += dsp_mix_sat_dsp( x ) != dsp_mix_sat_ref( x );
+		for ( int i = 0; i < 1 << 24; i++ )
+		{
+			int x = (int)rnd();
+			errors += dsp_mix_sat_dsp( x ) != dsp_mix_sat_ref( x );
+			errors += dsp_mix_sat_dsp( x >> 6 ) != dsp_mix_sat_ref( x >> 6 );
+		}
+		report( "dsp_mix_sat", errors );
+	}
+
+	{
+		uint64_t errors = 0;
+		for ( int i = 0; i < 1 << 24; i++ )
+		{
+			int x = (int)rnd() >> ( i & 15 );
+			errors += dsp_ssat16( x ) != ( x < -32768 ? -32768 : ( x > 32767 ? 32767 : x ) );
+			errors += dsp_usat8( x ) != ( x < 0 ? 0 : ( x > 255 ? 255 : x ) );
+		}
+		report( "dsp_ssat16, dsp_usat8", errors );
+	}
+
+	// the tap counts of the SAMPLE_DECIMATE stages, random symmetric coefficients, unaligned inputs
+	// (coefficients and accumulator are limited such that the sum does not overflow, as for the Q14 filters)
+	for ( int taps : { 6, 20 } )
+	{
+		uint64_t errors = 0;
+		alignas( 4 ) short h[ 20 ], x[ 21 ];
+		for ( int i = 0; i < 1 << 20; i++ )
+		{
+			for ( int j = 0; j < taps / 2; j++ )
+				h[ j ] = h[ taps - 1 - j ] = rndShort() >> 4;
+			for ( int j = 0; j <= taps; j++ )
+				x[ j ] = rndShort();
+			int acc = (int)rnd() >> 2;
+			int ref = dsp_fir_sym_ref( x + ( i & 1 ), h, taps, acc );
+			errors += dsp_fir_sym_dsp( x + ( i & 1 ), h, taps, acc ) != ref;
+			errors += dsp_fir_sym_folded( x + ( i & 1 ), h, taps, acc ) != ref;
+		}
+		char name[ 64 ];
+		snprintf( name, 64, "dsp_fir_sym (%d taps)", taps );
+		report( name, errors );
+	}
+
+	//
+	// voice 3 lookahead (voice3Ahead.h) vs. the chip clocked in the same steps: random voice settings with
+	// combined waveforms, sync/ring modulation and the test bit, both chip models
+	//
+	printf( "\n%-40s %10s\n", "OSC3/ENV3 lookahead (predictVoice3)", "result" );
+
+	for ( int model = 0; model < 2; model++ )
+	{
+		static SID16 sid;
+		sid.set_chip_model( model ? MOS8580 : MOS6581 );
+		sid.set_sampling_parameters( 985248, SAMPLE_INTERPOLATE, 44100 );
+		sid.power_on();
+
+		// entries and their spacing as in voice3Ahead.h
+		const int steps = 32, step = 8;
+		const uint8_t waveforms[] = { 0x10, 0x20, 0x40, 0x80, 0x30, 0x50, 0x60, 0x70 };
+		uint64_t errors = 0;
+
+		for ( int i = 0; i < 20000; i++ )
+		{
+			if ( ( i & 3 ) == 0 )
+			{
+				const int v = ( rnd() >> 8 ) % 3;
+				for ( int r = 0; r < 4; r++ )
+					sid.write( v * 7 + r, rnd() >> 8 );
+				sid.write( v * 7 + 5, rnd() >> 8 );
+				sid.write( v * 7 + 6, rnd() >> 8 );
+				// gate set mostly, sync, ring and test bit at random
+				uint32_t r = rnd() >> 8;
+				sid.write( v * 7 + 4, waveforms[ r & 7 ] | ( ( r >> 3 ) & 0x0e ) | ( ( r >> 7 ) & 3 ? 1 : 0 ) );
+			}
+
+			uint8_t osc3[ steps ], env3[ steps ];
+			sid.predictVoice3( osc3, env3, steps, step );
+			for ( int k = 0; k < steps; k++ )
+			{
+				errors += sid.read( 0x1b ) != osc3[ k ] || sid.read( 0x1c ) != env3[ k ];
+				sid.clock( step );
+			}
+		}
+
+		report( model ? "predictVoice3 (8580)" : "predictVoice3 (6581)", errors );
+	}
+
+	//
+	// DualSID16 vs. two SID16 clocked one after the other: random register writes and delta_t (with
+	// long silent spans for the filters to settle), both chip models, 6581 distortion, all accuracy tiers
+	//
+	printf( "\n%-40s %10s\n", "dual SID (DualSID16)", "result" );
+
+	{
+		struct DualConfig { const char *name; chip_model model[ 2 ]; int distortion; accuracy_tier accuracy; };
+		const DualConfig dualConfigs[] = {
+			{ "DualSID16 (6581+6581 distortion)", { MOS6581, MOS6581 }, 8, ACCURACY_DELTA },
+			{ "DualSID16 (6581+6581 dist., hybrid)", { MOS6581, MOS6581 }, 8, ACCURACY_HYBRID },
+			{ "DualSID16 (6581+6581)", { MOS6581, MOS6581 }, 0, ACCURACY_DELTA },
+			{ "DualSID16 (6581+8580 distortion)", { MOS6581, MOS8580 }, 8, ACCURACY_DELTA } };
+
+		for ( const DualConfig &dc : dualConfigs )
+		{
+			static DualSID16 dual;
+			static SID16 ref[ 2 ];
+			for ( int c = 0; c < 2; c++ )
+				for ( SID16 *s : { &dual.sid[ c ], &ref[ c ] } )
+				{
+					s->set_chip_model( dc.model[ c ] );
+					s->set_sampling_parameters( 985248, SAMPLE_INTERPOLATE, 44100 );
+					s->set_accuracy( dc.accuracy );
+					s->filter.set6581FilterCoeffs( (signed short*)&filterLUT6581[ 0 ], 220, 1800, dc.distortion );
+					s->power_on();
+				}
+
+			uint64_t errors = 0;
+			for ( int i = 0; i < 200000; i++ )
+			{
+				if ( ( i & 7 ) == 0 )
+				{
+					int c = ( rnd() >> 8 ) & 1;
+					uint8_t reg = ( rnd() >> 8 ) % 25, value = rnd() >> 8;
+					// gate off for a while now and then
+					if ( ( i & 0x3fff ) < 0x800 && reg % 7 == 4 ) value &= 0xfe;
+					dual.sid[ c ].write( reg, value );
+					ref[ c ].write( reg, value );
+				}
+
+				cycle_count dt = ( i & 0x3ff ) == 0 ? 20000 : 1 + ( ( rnd() >> 8 ) & 31 );
+				dual.clock( dt );
+				ref[ 0 ].clock( dt );
+				ref[ 1 ].clock( dt );
+				errors += dual.sid[ 0 ].output() != ref[ 0 ].output() || dual.sid[ 1 ].output() != ref[ 1 ].output();
+			}
+
+			report( dc.name, errors );
+		}
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  skpico_replay.cc
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// replays a bus trace (see busTrace.h) through the firmware's emulation core and writes the output
+// as WAV file; replay is deterministic, '-n' repeats it and checks that the output is bit-identical
+//
+// usage: skpico_replay <trace.sktr> [out.wav] [-c index=value]... [-d drain interval] [-l] [-n runs] [-r cycles] [-w]
+//
+//   -c  overrides entries of the configuration stored in the trace (indices as in reSIDWrapper.h)
+//   -d  the emulation core runs whenever a sample is due and every n cycles in between (default 8)
+//   -l  the emulation core runs every '-d' cycles only, not also when a sample is due: samples are rendered
+//       late, as on a device under load, the late samples and underruns of the sample FIFO are printed
+//   -r  adds reads of OSC3 of SID #1 every n cycles; for traces with OSC3/ENV3 reads, how much the values
+//       lag behind the bus is printed (with and without the lookahead of voice3Ahead.h), larger '-d' model
+//       a slower emulation loop
+//   -w  starts the 32-bit cycle counter one second before it wraps around (output must not change)
+//
+// when built with SKPICO_PROFILING, the per-phase statistics of the emulation loop are printed after each run
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "reSIDWrapper.h"
+#include "hostGlue.h"
+#include "traceReplay.h"
+#include "hostEmulation.h"
+
+#ifdef EMU_PROFILING
+static uint32_t get32( const uint8_t *p )
+{
+	return p[ 0 ] | ( p[ 1 ] << 8 ) | ( p[ 2 ] << 16 ) | ( (uint32_t)p[ 3 ] << 24 );
+}
+
+static void printProfile( const uint8_t *p )
+{
+	static const char *phaseName[] = { "drain", "emulate", "readRegs", "voice3", "fm", "mix", "audio out", "led", "busy/sample" };
+
+	int nPhases = p[ 1 ], nBins = p[ 2 ], firstBin = p[ 3 ];
+	uint32_t budget = get32( p + 4 );
+	printf( "  %u samples, %u late, budget %u ticks/sample, ring high-water %u, %u overflows, sample FIFO %u underruns, %u overflows\n", 
+			get32( p + 8 ), get32( p + 12 ), budget, get32( p + 16 ), get32( p + 20 ), get32( p + 24 ), get32( p + 28 ) );
+	printf( "  %-12s %8s %8s %8s  histogram (bin 0: < 2^%d ticks)\n", "phase", "min", "avg", "max", firstBin );
+	p += 32;
+	for ( int i = 0; i < nPhases; i++ )
+	{
+		printf( "  %-12s %8u %8u %8u ", i < (int)( sizeof( phaseName ) / sizeof( phaseName[ 0 ] ) ) ? phaseName[ i ] : "?", get32( p ), get32( p + 4 ), get32( p + 8 ) );
+		p += 12;
+		for ( int j = 0; j < nBins; j++, p += 2 )
+			printf( " %5u", p[ 0 ] | ( p[ 1 ] << 8 ) );
+		printf( "\n" );
+	}
+}
+#endif
+
+static int usage()
+{
+	fprintf( stderr, "usage: skpico_replay <trace.sktr> [out.wav] [-c index=value]... [-d drain interval] [-l] [-n runs] [-r cycles] [-w]\n" );
+	return 1;
+}
+
+int main( int argc, char **argv )
+{
+	const char *traceFile = NULL, *wavFile = NULL;
+	int drainInterval = 8, runs = 1, pollInterval = 0;
+	bool lateCore = false;
+	std::vector<std::pair<int, int>> overrides;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[ i ], "-c" ) == 0 && i + 1 < argc )
+		{
+			int idx, value;
+			if ( sscanf( argv[ ++ i ], "%d=%d", &idx, &value ) != 2 || idx < 0 || idx > 63 )
+				return usage();
+			overrides.push_back( { idx, value } );
+		} else
+		if ( strcmp( argv[ i ], "-d" ) == 0 && i + 1 < argc )
+			drainInterval = atoi( argv[ ++ i ] ); else
+		if ( strcmp( argv[ i ], "-l" ) == 0 )
+			lateCore = true; else
+		if ( strcmp( argv[ i ], "-n" ) == 0 && i + 1 < argc )
+			runs = atoi( argv[ ++ i ] ); else
+		if ( strcmp( argv[ i ], "-r" ) == 0 && i + 1 < argc )
+			pollInterval = atoi( argv[ ++ i ] ); else
+		if ( strcmp( argv[ i ], "-w" ) == 0 )
+			hostStartCycle = 0u - C64_CLOCK; else
+		if ( argv[ i ][ 0 ] == '-' )
+			return usage(); else
+		if ( traceFile == NULL )
+			traceFile = argv[ i ]; else
+		if ( wavFile == NULL )
+			wavFile = argv[ i ]; else
+			return usage();
+	}
+
+	if ( traceFile == NULL || runs < 1 || pollInterval < 0 || ( lateCore && drainInterval <= 0 ) )
+		return usage();
+
+	BUSTRACE_HEADER header;
+	std::vector<BUSTRACE_EVENT> events;
+	if ( !loadBusTrace( traceFile, header, events ) )
+	{
+		fprintf( stderr, "error reading '%s'\n", traceFile );
+		return 1;
+	}
+
+	if ( pollInterval )
+		addVoice3Polls( events, pollInterval );
+
+	std::vector<int16_t> pcm;
+	uint64_t firstChecksum = 0;
+
+	for ( int r = 0; r < runs; r++ )
+	{
+		setDefaultConfiguration();
+		memcpy( config, header.config, 64 );
+		for ( auto &o : overrides )
+			config[ o.first ] = o.second;
+		initReSID();
+
+		if ( r == 0 && C64_CLOCK != header.c64Clock )
+			fprintf( stderr, "warning: trace recorded at %d Hz, replaying at %d Hz\n", header.c64Clock, C64_CLOCK );
+
+		ReplayResult res;
+		pcm.clear();
+		replayBusTrace( events, drainInterval, wavFile ? &pcm : NULL, res, false, lateCore );
+
+		printf( "run %d: %llu cycles, %llu samples, %.3f s, %.2f ns/cycle, %.1fx realtime, checksum %016llx, ring high-water %u%s\n", r,
+				(unsigned long long)res.cycles, (unsigned long long)res.samples, res.wallSeconds,
+				res.wallSeconds * 1e9 / (double)res.cycles, (double)res.cycles / (double)C64_CLOCK / res.wallSeconds,
+				(unsigned long long)res.checksum, res.ringHighWater, res.ringOverflows ? " OVERFLOW" : "" );
+
+		if ( lateCore || res.sampleLate || res.sampleUnderruns || res.sampleOverflows )
+			printf( "  sample FIFO: %u late samples, %u underruns, %u overflows\n", res.sampleLate, res.sampleUnderruns, res.sampleOverflows );
+
+		if ( res.voice3Reads )
+			printf( "  %llu OSC3/ENV3 reads, lag in cycles: with lookahead avg %.1f p99 %u max %u, emulated only avg %.1f p99 %u max %u\n",
+					(unsigned long long)res.voice3Reads, res.voice3LagAvg[ 0 ], res.voice3LagP99[ 0 ], res.voice3LagMax[ 0 ],
+					res.voice3LagAvg[ 1 ], res.voice3LagP99[ 1 ], res.voice3LagMax[ 1 ] );
+
+		#ifdef EMU_PROFILING
+		printProfile( hostEmulationProfile() );
+		#endif
+
+		if ( r == 0 )
+			firstChecksum = res.checksum; else
+		if ( res.checksum != firstChecksum )
+		{
+			fprintf( stderr, "error: output of run %d differs from run 0\n", r );
+			return 1;
+		}
+	}
+
+	if ( wavFile && !writeWAV( wavFile, pcm, AUDIO_RATE ) )
+	{
+		fprintf( stderr, "error writing '%s'\n", wavFile );
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,220 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  skpico_ringstress.cc
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// stress test of the command ring (busRing.h) with the producer and the consumer on two threads,
+// as handleBus() and the emulation core on the two cores of the pico
+//
+// usage: skpico_ringstress [-n commands] [-s seed]
+//
+// the producer pushes numbered commands with time stamps derived from the number (including gaps
+// which require sync entries) and flushes the ring at random points; the consumer alternates between
+// ringPopBatch() and ringBeginBatch()/ringEndBatch(), and checks that the commands arrive in order, with
+// correctly reconstructed time stamps, and that commands are missing only where a flush discarded them.
+// A failure makes the exit code non-zero. Build with -DSKPICO_TSAN=ON to run it under ThreadSanitizer.
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "busRing.h"
+
+#define SEQ_MASK	0x3fff					// the command carries the lower bits of the sequence number
+
+// time stamp of command #seq: small increments and every 500 commands a gap needing a sync entry
+static uint32_t seqTime( uint32_t seq )
+{
+	return seq * 37 + ( seq / 500 ) * 70000 + ( ( seq * 2654435761u ) >> 28 );
+}
+
+static uint32_t producerNow = 0;			// the producer's c64CycleCounter
+static volatile int producerDone = 0;
+
+static std::vector<uint32_t> flushSeq;		// producer: a flush happened before pushing this command
+
+static void producer( uint32_t nCommands, uint32_t seed )
+{
+	uint32_t nextFlush = 1000 + seed % 5000;
+
+	for ( uint32_t seq = 0; seq < nCommands; seq ++ )
+	{
+		uint32_t t = seqTime( seq );
+		__atomic_store_n( &producerNow, t, __ATOMIC_RELAXED );
+
+		// back pressure instead of overflows: dropped commands would be indistinguishable from flushed ones
+		while ( ( ( ringWrite - RING_LOAD_ACQUIRE( ringRead ) ) & RING_MASK ) >= RING_SIZE - 4 )
+			std::this_thread::yield();
+
+		if ( seq == nextFlush )
+		{
+			flushSeq.push_back( seq );
+			ringFlush();
+			seed = seed * 1664525 + 1013904223;
+			nextFlush = seq + 1 + ( seed >> 8 ) % 8000;
+		}
+
+		ringPush( seq & SEQ_MASK, t );
+	}
+	RING_STORE_RELEASE( producerDone, 1 );
+}
+
+struct Gap { uint32_t from, to; };
+
+static uint32_t nReceived = 0, nBatches = 0, nSync = 0, nErrors = 0;
+static std::vector<Gap> gaps;
+
+static void consumeEntry( uint32_t entry, uint32_t &last, bool &first )
+{
+	if ( RING_IS_SYNC( entry ) )
+	{
+		ringReadTime = ringSyncTime( entry, __atomic_load_n( &producerNow, __ATOMIC_RELAXED ) );
+		nSync ++;
+		return;
+	}
+
+	uint32_t time = ringReadTime + RING_DELTA( entry );
+	ringReadTime = time;
+
+	uint32_t seq14 = RING_CMD( entry );
+	uint32_t seq = first ? seq14 : last + ( ( seq14 - last ) & SEQ_MASK );
+
+	if ( !first && seq == last )
+	{
+		if ( nErrors ++ < 10 )
+			printf( "  duplicate command #%u\n", seq );
+	} else
+	if ( time != seqTime( seq ) )
+	{
+		if ( nErrors ++ < 10 )
+			printf( "  command #%u: time stamp %u, expected %u\n", seq, time, seqTime( seq ) );
+	}
+
+	if ( ( first && seq != 0 ) || ( !first && seq > last + 1 ) )
+		gaps.push_back( { first ? 0 : last + 1, seq } );
+
+	last = seq;
+	first = false;
+	nReceived ++;
+}
+
+static void consumer()
+{
+	uint32_t last = 0, buf[ 64 ];
+	bool first = true;
+
+	for ( uint32_t round = 0; ; round ++ )
+	{
+		// must be read before the (final) batch: entries published until then are in it
+		int done = RING_LOAD_ACQUIRE( producerDone );
+		uint32_t n = 0;
+
+		if ( round & 1 )
+		{
+			n = ringPopBatch( buf, ( round >> 1 ) % 64 + 1 );
+			for ( uint32_t i = 0; i < n; i ++ )
+				consumeEntry( buf[ i ], last, first );
+		} else
+		{
+			RING_BATCH batch;
+			ringBeginBatch( &batch );
+			while ( batch.read != batch.end )
+			{
+				consumeEntry( ringBuf[ batch.read ], last, first );
+				batch.read = RING_NEXT( batch.read );
+				n ++;
+			}
+			ringEndBatch( &batch );
+		}
+
+		if ( n )
+			nBatches ++; else
+		{
+			if ( done ) break;
+			std::this_thread::yield();
+		}
+	}
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t nCommands = 4000000, seed = 1;
+
+	for ( int i = 1; i < argc; i ++ )
+	{
+		if ( !strcmp( argv[ i ], "-n" ) && i + 1 < argc )
+			nCommands = strtoul( argv[ ++ i ], NULL, 10 ); else
+		if ( !strcmp( argv[ i ], "-s" ) && i + 1 < argc )
+			seed = strtoul( argv[ ++ i ], NULL, 10 ); else
+		{
+			printf( "usage: %s [-n commands] [-s seed]\n", argv[ 0 ] );
+			return 1;
+		}
+	}
+
+	ringInit();
+
+	std::thread c( consumer );
+	std::thread p( producer, nCommands, seed );
+	p.join();
+	c.join();
+
+	// every missing range of commands must contain a flush
+	uint32_t nDiscarded = 0;
+	size_t f = 0;
+	for ( const Gap &g : gaps )
+	{
+		while ( f < flushSeq.size() && flushSeq[ f ] <= g.from )
+			f ++;
+		if ( f == flushSeq.size() || flushSeq[ f ] > g.to )
+		{
+			if ( nErrors ++ < 10 )
+				printf( "  commands #%u..#%u lost without a flush\n", g.from, g.to - 1 );
+		}
+		nDiscarded += g.to - g.from;
+	}
+	if ( ringOverflows )
+	{
+		printf( "  %u overflows\n", ringOverflows );
+		nErrors ++;
+	}
+
+	printf( "%u commands pushed, %u received, %u discarded by %u flushes\n", nCommands, nReceived, nDiscarded, (uint32_t)flushSeq.size() );
+	printf( "%u sync entries, %u batches (%.1f entries/batch), high water %u\n", nSync, nBatches, (double)( nReceived + nSync ) / ( nBatches ? nBatches : 1 ), ringHighWater );
+
+	// the commands not discarded by a flush must have arrived (the end of the sequence included)
+	if ( nReceived + nDiscarded != nCommands )
+	{
+		printf( "  %u commands missing\n", nCommands - nReceived - nDiscarded );
+		nErrors ++;
+	}
+
+	printf( nErrors ? "FAILED: %u errors\n" : "passed\n", nErrors );
+	return nErrors ? 1 : 0;
+}
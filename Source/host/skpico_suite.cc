@@ -0,0 +1,305 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  skpico_suite.cc
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// regression and performance suite: renders a fixed set of bus traces under all relevant 
+// combinations of the SID/filter/FM configuration and reports per combination
+//   - ns per emulated C64 cycle
+//   - peak and 99.9th percentile cost of a single output sample
+//   - hash of the output, and (if golden files are given) bit-exactness or SNR against them
+//
+// usage: skpico_suite [-s seconds] [-g golden dir [-u]] [-m min SNR dB] [-t trace.sktr]... [-f filter] [-c results.csv]
+//
+//   -g  directory with golden output (<trace>-<combination>.wav); a combination fails if its output
+//       is not bit-exact and below the minimum SNR (-m, default 90dB), or if golden output is missing
+//   -u  (re-)create the golden files instead of comparing
+//   -t  additional traces (using their stored configuration as base), besides the built-in synthetic ones
+//   -f  only run combinations whose name contains the filter string
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+#include "reSIDWrapper.h"
+#include "hostGlue.h"
+#include "traceReplay.h"
+
+struct SuiteTrace
+{
+	std::string name;
+	BUSTRACE_HEADER header;
+	std::vector<BUSTRACE_EVENT> events;
+	SynthTuneType type;			// what the trace exercises, determines the combinations
+};
+
+struct SuiteCombination
+{
+	std::string name;
+	std::vector<std::pair<uint8_t, uint8_t>> cfg;
+};
+
+static void addSIDCombinations( std::vector<SuiteCombination> &c, uint8_t cfgType, uint8_t cfgDigiboost, const char *prefix )
+{
+	char name[ 64 ];
+
+	// 6581: all filter presets, with and without distortion
+	for ( int preset = 0; preset < 20; preset++ )
+		for ( int distortion = 0; distortion <= 8; distortion += 8 )
+		{
+			sprintf( name, "%s6581-p%02d-d%d", prefix, preset, distortion );
+			c.push_back( { name, { { cfgType, 0 }, { CFG_FILTER_6581_PRESET, preset }, { CFG_FILTER_6581_DISTORTION, distortion } } } );
+		}
+
+	// 6581 with different filter range
+	sprintf( name, "%s6581-p00-range", prefix );
+	c.push_back( { name, { { cfgType, 0 }, { CFG_FILTER_6581_LOW, 0 }, { CFG_FILTER_6581_HIGH, 255 } } } );
+
+	// 8580, with different filter settings, 8580 with digiboost
+	sprintf( name, "%s8580", prefix );
+	c.push_back( { name, { { cfgType, 1 } } } );
+	sprintf( name, "%s8580-filter", prefix );
+	c.push_back( { name, { { cfgType, 1 }, { CFG_FILTER_8580_LOW, 40 }, { CFG_FILTER_8580_CENTER, 20 } } } );
+	sprintf( name, "%s8580-digiboost", prefix );
+	c.push_back( { name, { { cfgType, 2 }, { cfgDigiboost, 12 } } } );
+
+	// external filter off and with different cutoffs
+	sprintf( name, "%s6581-p00-extoff", prefix );
+	c.push_back( { name, { { cfgType, 0 }, { CFG_FILTER_EXT_ENABLE, 0 } } } );
+	sprintf( name, "%s6581-p00-extcut", prefix );
+	c.push_back( { name, { { cfgType, 0 }, { CFG_FILTER_EXT_HIGHPASS, 50 }, { CFG_FILTER_EXT_LOWPASS, 40 } } } );
+	sprintf( name, "%s8580-extoff", prefix );
+	c.push_back( { name, { { cfgType, 1 }, { CFG_FILTER_EXT_ENABLE, 0 } } } );
+	sprintf( name, "%s8580-extcut", prefix );
+	c.push_back( { name, { { cfgType, 1 }, { CFG_FILTER_EXT_HIGHPASS, 50 }, { CFG_FILTER_EXT_LOWPASS, 40 } } } );
+}
+
+static void buildCombinations( SynthTuneType type, std::vector<SuiteCombination> &c )
+{
+	c.clear();
+	switch ( type )
+	{
+	case SYNTH_DUAL:
+		c.push_back( { "6581+6581",   { { CFG_SID1_TYPE, 0 }, { CFG_SID2_TYPE, 0 } } } );
+		c.push_back( { "6581+6581-d8", { { CFG_SID1_TYPE, 0 }, { CFG_SID2_TYPE, 0 }, { CFG_FILTER_6581_DISTORTION, 8 } } } );
+		c.push_back( { "6581+8580",   { { CFG_SID1_TYPE, 0 }, { CFG_SID2_TYPE, 1 } } } );
+		c.push_back( { "8580+8580",   { { CFG_SID1_TYPE, 1 }, { CFG_SID2_TYPE, 1 } } } );
+		c.push_back( { "8580db+8580db", { { CFG_SID1_TYPE, 2 }, { CFG_SID2_TYPE, 2 } } } );
+		c.push_back( { "8580+8580-extoff", { { CFG_SID1_TYPE, 1 }, { CFG_SID2_TYPE, 1 }, { CFG_FILTER_EXT_ENABLE, 0 } } } );
+		break;
+	case SYNTH_FM:
+		c.push_back( { "6581+fm",      { { CFG_SID1_TYPE, 0 } } } );
+		c.push_back( { "8580+fm",      { { CFG_SID1_TYPE, 1 } } } );
+		c.push_back( { "8580+fm-extoff", { { CFG_SID1_TYPE, 1 }, { CFG_FILTER_EXT_ENABLE, 0 } } } );
+		break;
+	case SYNTH_DAC:
+		c.push_back( { "dac", {} } );
+		break;
+	default:
+		addSIDCombinations( c, CFG_SID1_TYPE, CFG_SID1_DIGIBOOST, "" );
+		break;
+	}
+}
+
+static double computeSNR( const std::vector<int16_t> &ref, const std::vector<int16_t> &test )
+{
+	double signal = 0.0, noise = 0.0;
+	for ( size_t i = 0; i < ref.size(); i++ )
+	{
+		double d = (double)ref[ i ] - (double)test[ i ];
+		signal += (double)ref[ i ] * (double)ref[ i ];
+		noise += d * d;
+	}
+	if ( noise == 0.0 ) return INFINITY;
+	if ( signal == 0.0 ) return -INFINITY;
+	return 10.0 * log10( signal / noise );
+}
+
+static uint64_t hashPCM( const std::vector<int16_t> &pcm )
+{
+	uint64_t h = 0xcbf29ce484222325ull;
+	for ( int16_t s : pcm )
+		h = ( h ^ (uint16_t)s ) * 0x100000001b3ull;
+	return h;
+}
+
+static int usage()
+{
+	fprintf( stderr, "usage: skpico_suite [-s seconds] [-g golden dir [-u]] [-m min SNR dB] [-t trace.sktr]... [-f filter] [-c results.csv]\n" );
+	return 1;
+}
+
+int main( int argc, char **argv )
+{
+	int seconds = 2;
+	const char *goldenDir = NULL, *filter = NULL, *csvFile = NULL;
+	bool updateGolden = false;
+	double minSNR = 90.0;
+	std::vector<const char *> traceFiles;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[ i ], "-s" ) == 0 && i + 1 < argc ) seconds = atoi( argv[ ++ i ] ); else
+		if ( strcmp( argv[ i ], "-g" ) == 0 && i + 1 < argc ) goldenDir = argv[ ++ i ]; else
+		if ( strcmp( argv[ i ], "-u" ) == 0 ) updateGolden = true; else
+		if ( strcmp( argv[ i ], "-m" ) == 0 && i + 1 < argc ) minSNR = atof( argv[ ++ i ] ); else
+		if ( strcmp( argv[ i ], "-t" ) == 0 && i + 1 < argc ) traceFiles.push_back( argv[ ++ i ] ); else
+		if ( strcmp( argv[ i ], "-f" ) == 0 && i + 1 < argc ) filter = argv[ ++ i ]; else
+		if ( strcmp( argv[ i ], "-c" ) == 0 && i + 1 < argc ) csvFile = argv[ ++ i ]; else
+			return usage();
+	}
+	if ( seconds < 1 || ( updateGolden && goldenDir == NULL ) )
+		return usage();
+
+	//
+	// the traces: synthetic ones, plus the ones given
+	//
+	std::vector<SuiteTrace> traces;
+
+	for ( int t = 0; t < SYNTH_TYPES; t++ )
+	{
+		SuiteTrace st;
+		st.name = synthTuneName[ t ];
+		st.type = (SynthTuneType)t;
+
+		setDefaultConfiguration();
+		synthTuneConfiguration( st.type, config );
+		initReSID();
+
+		std::vector<SynthWrite> writes;
+		uint64_t nCycles = (uint64_t)C64_CLOCK * seconds;
+		synthTune( writes, st.type, C64_CLOCK, nCycles );
+		makeBusTraceHeader( st.header );
+		encodeBusTrace( writes, nCycles, st.events );
+		traces.push_back( st );
+	}
+
+	for ( const char *fn : traceFiles )
+	{
+		SuiteTrace st;
+		if ( !loadBusTrace( fn, st.header, st.events ) )
+		{
+			fprintf( stderr, "error reading '%s'\n", fn );
+			return 1;
+		}
+		const char *base = strrchr( fn, '/' );
+		st.name = base ? base + 1 : fn;
+		st.name = st.name.substr( 0, st.name.find( '.' ) );
+		st.type = st.header.config[ CFG_SID2_TYPE ] >= 4 ? SYNTH_FM : st.header.config[ CFG_SID2_TYPE ] < 3 ? SYNTH_DUAL : SYNTH_SINGLE;
+		traces.push_back( st );
+	}
+
+	FILE *csv = NULL;
+	if ( csvFile )
+	{
+		csv = fopen( csvFile, "wt" );
+		if ( csv == NULL )
+		{
+			fprintf( stderr, "error writing '%s'\n", csvFile );
+			return 1;
+		}
+		fprintf( csv, "trace,combination,ns_per_cycle,peak_ns_per_sample,p999_ns_per_sample,hash,result\n" );
+	}
+
+	printf( "%-8s %-22s %10s %12s %12s %18s  %s\n", "trace", "combination", "ns/cycle", "peak ns/smp", "p99.9 ns/smp", "hash", "result" );
+
+	int nRuns = 0, nFailed = 0;
+	std::vector<SuiteCombination> combinations;
+	std::vector<int16_t> pcm, golden;
+
+	for ( const SuiteTrace &st : traces )
+	{
+		buildCombinations( st.type, combinations );
+
+		for ( const SuiteCombination &sc : combinations )
+		{
+			if ( filter && ( st.name + "-" + sc.name ).find( filter ) == std::string::npos )
+				continue;
+
+			setDefaultConfiguration();
+			memcpy( config, st.header.config, 64 );
+			for ( auto &c : sc.cfg )
+				config[ c.first ] = c.second;
+			initReSID();
+
+			ReplayResult res;
+			pcm.clear();
+			replayBusTrace( st.events, 8, &pcm, res, true );
+
+			char result[ 64 ] = "-";
+			if ( goldenDir )
+			{
+				std::string fn = std::string( goldenDir ) + "/" + st.name + "-" + sc.name + ".wav";
+				if ( updateGolden )
+				{
+					if ( !writeWAV( fn.c_str(), pcm, AUDIO_RATE ) )
+					{
+						fprintf( stderr, "error writing '%s'\n", fn.c_str() );
+						return 1;
+					}
+					strcpy( result, "golden written" );
+				} else
+				if ( !readWAV( fn.c_str(), golden ) )
+				{
+					strcpy( result, "FAIL (no golden file)" );
+					nFailed ++;
+				} else
+				if ( golden.size() != pcm.size() )
+				{
+					strcpy( result, "FAIL (length differs)" );
+					nFailed ++;
+				} else
+				if ( hashPCM( golden ) == res.checksum )
+				{
+					strcpy( result, "bit-exact" );
+				} else
+				{
+					double snr = computeSNR( golden, pcm );
+					bool ok = snr >= minSNR;
+					sprintf( result, "%s (SNR %.1f dB)", ok ? "ok" : "FAIL", snr );
+					if ( !ok ) nFailed ++;
+				}
+			}
+			nRuns ++;
+
+			double nsPerCycle = res.wallSeconds * 1e9 / (double)res.cycles;
+			printf( "%-8s %-22s %10.2f %12.0f %12.0f   %016llx  %s\n", st.name.c_str(), sc.name.c_str(), nsPerCycle, 
+					res.peakSampleNs, res.p999SampleNs, (unsigned long long)res.checksum, result );
+			if ( csv )
+				fprintf( csv, "%s,%s,%.3f,%.0f,%.0f,%016llx,%s\n", st.name.c_str(), sc.name.c_str(), nsPerCycle, 
+						 res.peakSampleNs, res.p999SampleNs, (unsigned long long)res.checksum, result );
+		}
+	}
+
+	if ( csv )
+		fclose( csv );
+
+	printf( "%d combinations, %d failed\n", nRuns, nFailed );
+	return nFailed ? 1 : 0;
+}
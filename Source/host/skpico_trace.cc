@@ -0,0 +1,215 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  skpico_trace.cc
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// creates and inspects bus traces (see busTrace.h)
+//
+// usage: skpico_trace synth <out.sktr> <single|dual|fm|digi|dac> [seconds]
+//        skpico_trace text  <in.txt> <out.sktr> [single|dual|fm|digi|dac]
+//        skpico_trace dump  <in.sktr>
+//
+// text format (also the output of 'dump'), one bus access per line:
+//   <delta cycles> <sid1|sid2|fm> <w|r> <register, hex> <value, hex>
+//   <delta cycles> end
+// '#' starts a comment. The configuration stored in the trace is the default one, with 
+// SID #2/FM set up according to the tune type (default: single).
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "reSIDWrapper.h"
+#include "hostGlue.h"
+#include "traceReplay.h"
+
+static const char *chipName[ 3 ] = { "sid1", "sid2", "fm" };
+
+static int usage()
+{
+	fprintf( stderr, "usage: skpico_trace synth <out.sktr> <single|dual|fm|digi|dac> [seconds]\n"
+					 "       skpico_trace text  <in.txt> <out.sktr> [single|dual|fm|digi|dac]\n"
+					 "       skpico_trace dump  <in.sktr>\n" );
+	return 1;
+}
+
+static int tuneType( const char *name )
+{
+	for ( int i = 0; i < SYNTH_TYPES; i++ )
+		if ( strcmp( name, synthTuneName[ i ] ) == 0 )
+			return i;
+	return -1;
+}
+
+static void setupConfiguration( SynthTuneType type )
+{
+	setDefaultConfiguration();
+	synthTuneConfiguration( type, config );
+	initReSID();
+}
+
+static int synth( const char *filename, const char *type, int seconds )
+{
+	int t = tuneType( type );
+	if ( t < 0 ) return usage();
+
+	setupConfiguration( (SynthTuneType)t );
+
+	uint64_t nCycles = (uint64_t)C64_CLOCK * seconds;
+	std::vector<SynthWrite> writes;
+	synthTune( writes, (SynthTuneType)t, C64_CLOCK, nCycles );
+
+	BUSTRACE_HEADER header;
+	std::vector<BUSTRACE_EVENT> events;
+	makeBusTraceHeader( header );
+	encodeBusTrace( writes, nCycles, events );
+
+	if ( !saveBusTrace( filename, header, events ) )
+	{
+		fprintf( stderr, "error writing '%s'\n", filename );
+		return 1;
+	}
+	printf( "%s: %d events, %llu cycles\n", filename, (int)events.size(), (unsigned long long)nCycles );
+	return 0;
+}
+
+static int text( const char *in, const char *out, const char *type )
+{
+	int t = tuneType( type );
+	if ( t < 0 ) return usage();
+
+	FILE *f = fopen( in, "rt" );
+	if ( f == NULL )
+	{
+		fprintf( stderr, "error reading '%s'\n", in );
+		return 1;
+	}
+
+	setupConfiguration( (SynthTuneType)t );
+
+	BUSTRACE_HEADER header;
+	std::vector<BUSTRACE_EVENT> events;
+	makeBusTraceHeader( header );
+
+	char line[ 256 ];
+	int  lineNr = 0;
+	while ( fgets( line, sizeof( line ), f ) )
+	{
+		lineNr ++;
+		if ( char *c = strchr( line, '#' ) ) *c = 0;
+
+		unsigned long delta;
+		char chip[ 16 ], rw[ 16 ];
+		unsigned int reg, value;
+
+		int n = sscanf( line, "%lu %15s %15s %x %x", &delta, chip, rw, &reg, &value );
+		if ( n <= 0 ) 
+			continue;
+
+		uint64_t d = delta;
+		while ( d > BUSTRACE_MAX_DELTA16 )
+		{
+			uint32_t s = d > BUSTRACE_MAX_DELTA29 ? BUSTRACE_MAX_DELTA29 : (uint32_t)d;
+			events.push_back( busTraceDeltaEvent( s ) );
+			d -= s;
+		}
+
+		if ( n == 2 && strcmp( chip, "end" ) == 0 )
+		{
+			if ( d ) events.push_back( busTraceDeltaEvent( (uint32_t)d ) );
+			continue;
+		}
+
+		int c = 0;
+		while ( c < 3 && strcmp( chip, chipName[ c ] ) ) c ++;
+
+		if ( n != 5 || c == 3 || ( rw[ 0 ] != 'w' && rw[ 0 ] != 'r' ) || reg > 0x1f || value > 0xff )
+		{
+			fprintf( stderr, "%s:%d: syntax error\n", in, lineNr );
+			fclose( f );
+			return 1;
+		}
+
+		uint8_t kind = ( rw[ 0 ] == 'w' ? BT_WRITE_SID1 : BT_READ_SID1 ) + c;
+		events.push_back( busTraceEvent( kind, reg, value, (uint16_t)d ) );
+	}
+	fclose( f );
+
+	if ( !saveBusTrace( out, header, events ) )
+	{
+		fprintf( stderr, "error writing '%s'\n", out );
+		return 1;
+	}
+	printf( "%s: %d events\n", out, (int)events.size() );
+	return 0;
+}
+
+static int dump( const char *filename )
+{
+	BUSTRACE_HEADER header;
+	std::vector<BUSTRACE_EVENT> events;
+
+	if ( !loadBusTrace( filename, header, events ) )
+	{
+		fprintf( stderr, "error reading '%s'\n", filename );
+		return 1;
+	}
+
+	printf( "# %s: %d events, C64 clock %d Hz\n# config:", filename, header.nEvents, header.c64Clock );
+	for ( int i = 0; i < 64; i++ )
+		printf( " %02x", header.config[ i ] );
+	printf( "\n" );
+
+	uint64_t delta = 0;
+	for ( const BUSTRACE_EVENT &e : events )
+	{
+		delta += busTraceDelta( e );
+		uint8_t kind = BUSTRACE_KIND( e );
+		if ( kind == BT_DELTA )
+			continue;
+		printf( "%llu %s %c %02x %02x\n", (unsigned long long)delta, chipName[ kind % 3 ], kind < BT_READ_SID1 ? 'w' : 'r', BUSTRACE_REG( e ), e.value );
+		delta = 0;
+	}
+	if ( delta )
+		printf( "%llu end\n", (unsigned long long)delta );
+
+	return 0;
+}
+
+int main( int argc, char **argv )
+{
+	if ( argc >= 4 && strcmp( argv[ 1 ], "synth" ) == 0 )
+		return synth( argv[ 2 ], argv[ 3 ], argc > 4 ? atoi( argv[ 4 ] ) : 10 );
+
+	if ( argc >= 4 && strcmp( argv[ 1 ], "text" ) == 0 )
+		return text( argv[ 2 ], argv[ 3 ], argc > 4 ? argv[ 4 ] : "single" );
+
+	if ( argc == 3 && strcmp( argv[ 1 ], "dump" ) == 0 )
+		return dump( argv[ 2 ] );
+
+	return usage();
+}
@@ -0,0 +1,220 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  synthTune.cc
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+
+#include "synthTune.h"
+#include "reSIDWrapper.h"
+
+const char *synthTuneName[ SYNTH_TYPES ] = { "single", "dual", "fm", "digi", "dac" };
+
+static uint32_t lcgState;
+
+static uint32_t lcg()
+{
+	lcgState = lcgState * 1664525u + 1013904223u;
+	return lcgState >> 8;
+}
+
+// one "player call" per frame: new notes, gate-offs, pulse-width and filter sweeps
+static void generateSIDFrame( std::vector<SynthWrite> &w, uint32_t &c, uint32_t frame, uint8_t chip )
+{
+	static const uint8_t waveforms[ 5 ] = { 0x11, 0x21, 0x41, 0x81, 0x51 };
+
+	#define W( a, d ) { w.push_back( { c, chip, (uint8_t)( a ), (uint8_t)( d ) } ); c += 8 + ( lcg() & 7 ); }
+
+	for ( int v = 0; v < 3; v++ )
+	{
+		uint8_t r = v * 7;
+		uint32_t rnd = lcg();
+		if ( ( rnd & 7 ) == 0 )
+		{
+			// new note
+			uint16_t freq = 0x400 + ( lcg() & 0x3fff );
+			uint8_t  wf = waveforms[ lcg() % 5 ];
+			W( r + 0, freq );
+			W( r + 1, freq >> 8 );
+			W( r + 5, lcg() );
+			W( r + 6, lcg() );
+			W( r + 4, wf & 0xfe );
+			W( r + 4, wf );
+		} else
+		if ( ( rnd & 7 ) == 1 )
+		{
+			// gate off
+			W( r + 4, 0x40 );
+		} else
+		{
+			// vibrato and pulse width modulation
+			W( r + 0, lcg() );
+			W( r + 2, frame * ( v + 1 ) * 5 );
+			W( r + 3, ( frame * ( v + 1 ) * 5 ) >> 8 );
+		}
+	}
+
+	uint16_t cutoff = ( frame * 13 ) & 2047;
+	W( 0x15, cutoff & 7 );
+	W( 0x16, cutoff >> 3 );
+	W( 0x17, 0xf0 | ( frame >> 6 & 7 ) );
+	W( 0x18, 0x1f | ( ( frame >> 8 & 1 ) << 5 ) );
+
+	#undef W
+}
+
+static void generateFMFrame( std::vector<SynthWrite> &w, uint32_t &c, uint32_t frame )
+{
+	#define FM( r, d ) {	w.push_back( { c, HOST_CHIP_FM, 0x00, (uint8_t)( r ) } ); c += 6; \
+							w.push_back( { c, HOST_CHIP_FM, 0x10, (uint8_t)( d ) } ); c += 12; }
+
+	if ( frame == 0 )
+	{
+		FM( 0x01, 0x20 );
+		for ( int op = 0; op < 0x16; op++ )
+		{
+			if ( ( op & 7 ) > 5 ) continue;
+			FM( 0x20 + op, 0x21 + ( op & 3 ) );
+			FM( 0x40 + op, ( op & 1 ) ? 0x00 : 0x18 );
+			FM( 0x60 + op, 0xf4 );
+			FM( 0x80 + op, 0x36 );
+			FM( 0xe0 + op, op & 3 );
+		}
+		for ( int ch = 0; ch < 9; ch++ )
+			FM( 0xc0 + ch, 0x0e );
+	}
+
+	int ch = frame % 9;
+	uint16_t fnum = 0x150 + ( lcg() & 0x1ff );
+	FM( 0xb0 + ch, 0 );
+	FM( 0xa0 + ch, fnum );
+	FM( 0xb0 + ch, 0x20 | ( ( 2 + ( lcg() & 3 ) ) << 2 ) | ( fnum >> 8 ) );
+
+	#undef FM
+}
+
+// sample played by the digi patterns: two detuned sines
+static uint8_t digiSample( uint32_t n )
+{
+	float t = (float)n / 7812.5f;
+	return (uint8_t)( 128.0f + 60.0f * sinf( t * 2.0f * 3.1415926535f * 220.0f ) + 40.0f * sinf( t * 2.0f * 3.1415926535f * 331.0f ) );
+}
+
+void synthTune( std::vector<SynthWrite> &w, SynthTuneType type, uint32_t c64Clock, uint64_t nCycles )
+{
+	const uint32_t cyclesPerFrame = c64Clock / 50;
+	lcgState = 0x5eed;
+	w.clear();
+
+	if ( type == SYNTH_DIGI || type == SYNTH_DAC )
+	{
+		// ~7.8kHz sample rate, a "player" in the main loop and the digi in the interrupt
+		const uint32_t cyclesPerDigi = c64Clock / 7812;
+		std::vector<SynthWrite> digi;
+		uint32_t n = 0;
+
+		if ( type == SYNTH_DAC )
+			digi.push_back( { 0, HOST_CHIP_SID1, 0x1f, 0xfc } );
+
+		for ( uint64_t c = 64; c < nCycles; c += cyclesPerDigi, n ++ )
+		{
+			uint8_t s = digiSample( n );
+			uint32_t t = (uint32_t)c;
+			if ( type == SYNTH_DAC )
+			{
+				digi.push_back( { t, HOST_CHIP_SID1, 0x18, s } );
+			} else
+			if ( ( n / 4096 ) & 1 )
+			{
+				// test-bit technique on voice 1: $11 (prepare), $09 (test bit), sample to $d401, $01 (gate)
+				digi.push_back( { t, HOST_CHIP_SID1, 0x04, 0x11 } ); t += 8;
+				digi.push_back( { t, HOST_CHIP_SID1, 0x04, 0x09 } ); t += 8;
+				digi.push_back( { t, HOST_CHIP_SID1, 0x01, s } ); t += 6;
+				digi.push_back( { t, HOST_CHIP_SID1, 0x04, 0x01 } );
+			} else
+			{
+				// classic 4-bit volume register digi
+				digi.push_back( { t, HOST_CHIP_SID1, 0x18, (uint8_t)( 0x10 | ( s >> 4 ) ) } );
+			}
+		}
+
+		if ( type == SYNTH_DAC )
+		{
+			w = digi;
+			return;
+		}
+
+		// merge with a player on voices 2 and 3 (no filter/volume writes which would interfere with the digis)
+		std::vector<SynthWrite> player;
+		for ( uint32_t frame = 0; (uint64_t)frame * cyclesPerFrame < nCycles; frame++ )
+		{
+			uint32_t c = frame * cyclesPerFrame + cyclesPerDigi / 2;
+			std::vector<SynthWrite> f;
+			generateSIDFrame( f, c, frame, HOST_CHIP_SID1 );
+			for ( const SynthWrite &sw : f )
+				if ( sw.reg >= 7 && sw.reg < 0x15 )
+					player.push_back( sw );
+		}
+
+		size_t i = 0, j = 0;
+		while ( i < digi.size() || j < player.size() )
+		{
+			if ( j >= player.size() || ( i < digi.size() && digi[ i ].cycle <= player[ j ].cycle ) )
+				w.push_back( digi[ i ++ ] ); else
+				w.push_back( player[ j ++ ] );
+		}
+		return;
+	}
+
+	for ( uint32_t frame = 0; (uint64_t)frame * cyclesPerFrame < nCycles; frame++ )
+	{
+		uint32_t c = frame * cyclesPerFrame;
+		generateSIDFrame( w, c, frame, HOST_CHIP_SID1 );
+		if ( type == SYNTH_DUAL )
+			generateSIDFrame( w, c, frame + 1000, HOST_CHIP_SID2 );
+		if ( type == SYNTH_FM )
+			generateFMFrame( w, c, frame );
+	}
+}
+
+void synthTuneConfiguration( SynthTuneType type, uint8_t *cfg )
+{
+	switch ( type )
+	{
+	case SYNTH_DUAL:
+		cfg[ CFG_SID2_TYPE ] = 1;
+		cfg[ CFG_SID2_ADDRESS ] = 1;
+		break;
+	case SYNTH_FM:
+		cfg[ CFG_SID2_TYPE ] = 5;
+		break;
+	case SYNTH_DIGI:
+		cfg[ CFG_SID2_TYPE ] = 3;
+		cfg[ CFG_DIGIDETECT ] = 1;
+		break;
+	default:
+		cfg[ CFG_SID2_TYPE ] = 3;
+		break;
+	}
+}
@@ -0,0 +1,67 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  synthTune.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// deterministic synthetic workloads for the host tools (benchmark, traces): a simple 
+// "player" writing SID (and optionally OPL) registers once per frame, and digi-playing 
+// patterns exercising the digi-detection and the DAC modes
+//
+
+#ifndef _SKPICO_SYNTHTUNE_H_
+#define _SKPICO_SYNTHTUNE_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "hostEmulation.h"
+
+struct SynthWrite
+{
+	uint32_t cycle;
+	uint8_t  chip;		// HOST_CHIP_*
+	uint8_t  reg;		// as seen by handleBus (FM: 0x00 address, 0x10 data port)
+	uint8_t  value;
+};
+
+enum SynthTuneType
+{
+	SYNTH_SINGLE = 0,	// SID #1 only
+	SYNTH_DUAL,			// SID #1 + SID #2
+	SYNTH_FM,			// SID #1 + OPL
+	SYNTH_DIGI,			// SID #1 + $d418 4-bit digis + test-bit digis on voice 1
+	SYNTH_DAC,			// 8-bit DAC mode ($d41f = $fc)
+	SYNTH_TYPES
+};
+
+extern const char *synthTuneName[ SYNTH_TYPES ];
+
+// writes for 'nCycles' cycles of the C64 running at 'c64Clock', sorted by cycle
+extern void synthTune( std::vector<SynthWrite> &w, SynthTuneType type, uint32_t c64Clock, uint64_t nCycles );
+
+// configuration matching a tune type (SID #2 / FM enabled or not)
+extern void synthTuneConfiguration( SynthTuneType type, uint8_t *cfg );
+
+#endif
@@ -0,0 +1,316 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  traceReplay.cc
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+
+#include "traceReplay.h"
+#include "hostGlue.h"
+#include "hostEmulation.h"
+
+bool loadBusTrace( const char *filename, BUSTRACE_HEADER &header, std::vector<BUSTRACE_EVENT> &events )
+{
+	FILE *f = fopen( filename, "rb" );
+	if ( f == NULL )
+		return false;
+
+	bool ok = fread( &header, sizeof( BUSTRACE_HEADER ), 1, f ) == 1 &&
+			  header.magic == BUSTRACE_MAGIC && header.version == BUSTRACE_VERSION &&
+			  header.headerSize >= sizeof( BUSTRACE_HEADER );
+
+	if ( ok )
+	{
+		fseek( f, header.headerSize, SEEK_SET );
+		events.resize( header.nEvents );
+		ok = fread( events.data(), sizeof( BUSTRACE_EVENT ), header.nEvents, f ) == header.nEvents;
+	}
+
+	fclose( f );
+	return ok;
+}
+
+bool saveBusTrace( const char *filename, const BUSTRACE_HEADER &header, const std::vector<BUSTRACE_EVENT> &events )
+{
+	FILE *f = fopen( filename, "wb" );
+	if ( f == NULL )
+		return false;
+
+	BUSTRACE_HEADER h = header;
+	h.nEvents = (uint32_t)events.size();
+
+	bool ok = fwrite( &h, sizeof( BUSTRACE_HEADER ), 1, f ) == 1 &&
+			  fwrite( events.data(), sizeof( BUSTRACE_EVENT ), events.size(), f ) == events.size();
+
+	fclose( f );
+	return ok;
+}
+
+void makeBusTraceHeader( BUSTRACE_HEADER &header )
+{
+	memset( &header, 0, sizeof( BUSTRACE_HEADER ) );
+	header.magic = BUSTRACE_MAGIC;
+	header.version = BUSTRACE_VERSION;
+	header.headerSize = sizeof( BUSTRACE_HEADER );
+	header.c64Clock = C64_CLOCK;
+	memcpy( header.config, config, 64 );
+}
+
+static void encodeDelta( uint64_t &delta, std::vector<BUSTRACE_EVENT> &events )
+{
+	while ( delta > BUSTRACE_MAX_DELTA16 )
+	{
+		uint32_t d = delta > BUSTRACE_MAX_DELTA29 ? BUSTRACE_MAX_DELTA29 : (uint32_t)delta;
+		events.push_back( busTraceDeltaEvent( d ) );
+		delta -= d;
+	}
+}
+
+void encodeBusTrace( const std::vector<SynthWrite> &writes, uint64_t endCycle, std::vector<BUSTRACE_EVENT> &events )
+{
+	static const uint8_t kind[ 3 ] = { BT_WRITE_SID1, BT_WRITE_SID2, BT_WRITE_FM };
+
+	uint64_t cycle = 0;
+	events.clear();
+	for ( const SynthWrite &w : writes )
+	{
+		uint64_t delta = w.cycle - cycle;
+		encodeDelta( delta, events );
+		events.push_back( busTraceEvent( kind[ w.chip ], w.reg, w.value, (uint16_t)delta ) );
+		cycle = w.cycle;
+	}
+
+	if ( endCycle > cycle )
+	{
+		uint64_t delta = endCycle - cycle;
+		encodeDelta( delta, events );
+		if ( delta )
+			events.push_back( busTraceDeltaEvent( (uint32_t)delta ) );
+	}
+}
+
+void addVoice3Polls( std::vector<BUSTRACE_EVENT> &events, uint32_t interval )
+{
+	std::vector<BUSTRACE_EVENT> out;
+	uint64_t cycle = 0, lastCycle = 0, nextPoll = interval;
+
+	auto emit = [&]( uint8_t kind, uint8_t reg, uint8_t value, uint64_t at )
+	{
+		uint64_t delta = at - lastCycle;
+		encodeDelta( delta, out );
+		out.push_back( busTraceEvent( kind, reg, value, (uint16_t)delta ) );
+		lastCycle = at;
+	};
+
+	for ( const BUSTRACE_EVENT &e : events )
+	{
+		cycle += busTraceDelta( e );
+
+		for ( ; interval && nextPoll <= cycle; nextPoll += interval )
+			emit( BT_READ_SID1, 0x1b, 0, nextPoll );
+
+		if ( BUSTRACE_KIND( e ) != BT_DELTA )
+			emit( BUSTRACE_KIND( e ), BUSTRACE_REG( e ), e.value, cycle );
+	}
+
+	if ( cycle > lastCycle )
+	{
+		uint64_t delta = cycle - lastCycle;
+		encodeDelta( delta, out );
+		if ( delta )
+			out.push_back( busTraceDeltaEvent( (uint32_t)delta ) );
+	}
+
+	events.swap( out );
+}
+
+static void lagStatistics( const std::vector<uint32_t> &histogram, double &avg, uint32_t &p99, uint32_t &max )
+{
+	uint64_t n = 0, sum = 0;
+	for ( size_t i = 0; i < histogram.size(); i++ )
+	{
+		n += histogram[ i ];
+		sum += histogram[ i ] * (uint64_t)i;
+		if ( histogram[ i ] )
+			max = (uint32_t)i;
+	}
+	avg = n ? (double)sum / n : 0.0;
+
+	uint64_t acc = 0;
+	for ( p99 = 0; n && p99 < histogram.size(); p99++ )
+		if ( ( acc += histogram[ p99 ] ) * 100 >= n * 99 )
+			break;
+}
+
+void replayBusTrace( const std::vector<BUSTRACE_EVENT> &events, int drainInterval, std::vector<int16_t> *pcm, ReplayResult &result, bool timeSamples, bool lateCore )
+{
+	hostEmulationInit();
+
+	std::vector<uint32_t> lagHistogram[ 2 ];
+	for ( int i = 0; i < 2; i++ )
+	{
+		lagHistogram[ i ].assign( HOST_LAG_HISTOGRAM_SIZE, 0 );
+		hostVoice3LagHistogram[ i ] = lagHistogram[ i ].data();
+	}
+
+	uint64_t checksum = 0xcbf29ce484222325ull;
+	uint64_t eventCycle = 0, busCycle = 0, nSamples = 0;
+	int drainCounter = 0;
+	std::vector<uint32_t> sampleNs;
+	auto t0 = std::chrono::steady_clock::now();
+	auto tLastSample = t0;
+
+	auto runCore = [&]()
+	{
+		int16_t L, R;
+		while ( hostEmulationRun( &L, &R ) )
+		{
+			checksum = ( checksum ^ (uint16_t)L ) * 0x100000001b3ull;
+			checksum = ( checksum ^ (uint16_t)R ) * 0x100000001b3ull;
+			if ( timeSamples )
+			{
+				auto t = std::chrono::steady_clock::now();
+				sampleNs.push_back( (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>( t - tLastSample ).count() );
+				tLastSample = t;
+			}
+			if ( pcm )
+			{
+				pcm->push_back( L );
+				pcm->push_back( R );
+			}
+			nSamples ++;
+		}
+	};
+
+	for ( const BUSTRACE_EVENT &e : events )
+	{
+		eventCycle += busTraceDelta( e );
+
+		// run the bus up to the event's cycle
+		while ( busCycle < eventCycle )
+		{
+			busCycle ++;
+			int sampleDue = hostBusCycle();
+			if ( ( sampleDue && !lateCore ) || ( drainInterval > 0 && ++ drainCounter >= drainInterval ) )
+			{
+				drainCounter = 0;
+				runCore();
+			}
+		}
+
+		switch ( BUSTRACE_KIND( e ) )
+		{
+		case BT_WRITE_SID1: hostBusWrite( HOST_CHIP_SID1, BUSTRACE_REG( e ), e.value ); break;
+		case BT_WRITE_SID2: hostBusWrite( HOST_CHIP_SID2, BUSTRACE_REG( e ), e.value ); break;
+		case BT_WRITE_FM:   hostBusWrite( HOST_CHIP_FM, BUSTRACE_REG( e ), e.value ); break;
+		case BT_READ_SID1:  hostBusRead( HOST_CHIP_SID1, BUSTRACE_REG( e ) ); break;
+		case BT_READ_SID2:  hostBusRead( HOST_CHIP_SID2, BUSTRACE_REG( e ) ); break;
+		case BT_READ_FM:    hostBusRead( HOST_CHIP_FM, BUSTRACE_REG( e ) ); break;
+		default: break;
+		}
+	}
+
+	if ( lateCore )
+		runCore();
+
+	result.cycles = busCycle;
+	result.samples = nSamples;
+	result.wallSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+	result.checksum = checksum;
+	result.ringHighWater = ringHighWater;
+	result.ringOverflows = ringOverflows;
+	result.sampleLate = sampleFifoLate;
+	result.sampleUnderruns = sampleFifoUnderruns;
+	result.sampleOverflows = sampleFifoOverflows;
+	result.peakSampleNs = result.p999SampleNs = 0.0;
+
+	hostVoice3LagHistogram[ 0 ] = hostVoice3LagHistogram[ 1 ] = NULL;
+	result.voice3Reads = 0;
+	for ( uint32_t c : lagHistogram[ 1 ] )
+		result.voice3Reads += c;
+	for ( int i = 0; i < 2; i++ )
+	{
+		result.voice3LagMax[ i ] = 0;
+		lagStatistics( lagHistogram[ i ], result.voice3LagAvg[ i ], result.voice3LagP99[ i ], result.voice3LagMax[ i ] );
+	}
+
+	if ( !sampleNs.empty() )
+	{
+		result.peakSampleNs = *std::max_element( sampleNs.begin(), sampleNs.end() );
+		size_t k = sampleNs.size() * 999 / 1000;
+		std::nth_element( sampleNs.begin(), sampleNs.begin() + k, sampleNs.end() );
+		result.p999SampleNs = sampleNs[ k ];
+	}
+}
+
+static void put32( FILE *f, uint32_t v ) { fwrite( &v, 4, 1, f ); }
+static void put16( FILE *f, uint16_t v ) { fwrite( &v, 2, 1, f ); }
+
+bool writeWAV( const char *filename, const std::vector<int16_t> &pcm, uint32_t sampleRate )
+{
+	FILE *f = fopen( filename, "wb" );
+	if ( f == NULL )
+		return false;
+
+	uint32_t dataSize = (uint32_t)( pcm.size() * sizeof( int16_t ) );
+
+	fwrite( "RIFF", 4, 1, f ); put32( f, 36 + dataSize );
+	fwrite( "WAVE", 4, 1, f );
+	fwrite( "fmt ", 4, 1, f ); put32( f, 16 );
+	put16( f, 1 );						// PCM
+	put16( f, 2 );						// stereo
+	put32( f, sampleRate );
+	put32( f, sampleRate * 4 );
+	put16( f, 4 );
+	put16( f, 16 );
+	fwrite( "data", 4, 1, f ); put32( f, dataSize );
+	bool ok = fwrite( pcm.data(), sizeof( int16_t ), pcm.size(), f ) == pcm.size();
+
+	fclose( f );
+	return ok;
+}
+
+bool readWAV( const char *filename, std::vector<int16_t> &pcm )
+{
+	FILE *f = fopen( filename, "rb" );
+	if ( f == NULL )
+		return false;
+
+	// only what writeWAV() produces: 44 byte header, 16 bit stereo
+	uint8_t hdr[ 44 ];
+	bool ok = fread( hdr, 44, 1, f ) == 1 && memcmp( hdr, "RIFF", 4 ) == 0 && memcmp( hdr + 36, "data", 4 ) == 0;
+	if ( ok )
+	{
+		uint32_t dataSize;
+		memcpy( &dataSize, hdr + 40, 4 );
+		pcm.resize( dataSize / sizeof( int16_t ) );
+		ok = fread( pcm.data(), sizeof( int16_t ), pcm.size(), f ) == pcm.size();
+	}
+
+	fclose( f );
+	return ok;
+}
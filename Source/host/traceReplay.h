@@ -0,0 +1,85 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  traceReplay.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl 
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// loading/saving bus traces (see busTrace.h) and replaying them through the emulation core
+//
+
+#ifndef _SKPICO_TRACEREPLAY_H_
+#define _SKPICO_TRACEREPLAY_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "busTrace.h"
+#include "synthTune.h"
+
+struct ReplayResult
+{
+	uint64_t cycles;
+	uint64_t samples;
+	double   wallSeconds;	// including the (cheap) bus stand-in
+	uint64_t checksum;		// FNV-1a of the 16-bit stereo output
+	double   peakSampleNs;	// cost of the most expensive sample (only if requested)
+	double   p999SampleNs;	// 99.9th percentile of the per-sample cost
+	uint32_t ringHighWater;	// maximum fill level of the ring buffer
+	uint32_t ringOverflows;	// dropped commands
+	uint32_t sampleLate;		// samples rendered after the following tick (sampleFifo.h)
+	uint32_t sampleUnderruns;	// ticks without a sample in the FIFO
+	uint32_t sampleOverflows;	// samples dropped as the FIFO was full
+
+	// OSC3/ENV3 reads: how many cycles the returned values lag behind the bus, [ 0 ] with the lookahead
+	// of voice3Ahead.h, [ 1 ] from the emulated registers only
+	uint64_t voice3Reads;
+	double   voice3LagAvg[ 2 ];
+	uint32_t voice3LagP99[ 2 ], voice3LagMax[ 2 ];
+};
+
+extern bool loadBusTrace( const char *filename, BUSTRACE_HEADER &header, std::vector<BUSTRACE_EVENT> &events );
+extern bool saveBusTrace( const char *filename, const BUSTRACE_HEADER &header, const std::vector<BUSTRACE_EVENT> &events );
+
+// header with the current configuration, and the events for a list of timed writes (followed by a BT_DELTA up to 'endCycle')
+extern void makeBusTraceHeader( BUSTRACE_HEADER &header );
+extern void encodeBusTrace( const std::vector<SynthWrite> &writes, uint64_t endCycle, std::vector<BUSTRACE_EVENT> &events );
+
+// adds reads of OSC3 of SID #1 every 'interval' cycles (as a tune polling voice 3 would)
+extern void addVoice3Polls( std::vector<BUSTRACE_EVENT> &events, uint32_t interval );
+
+//
+// replays the events through the bus stand-in and emulation core; reSID must have been initialized 
+// with the configuration to use. The emulation core runs whenever a sample is due and every 
+// 'drainInterval' cycles in between (on the device it runs continuously with a small lag).
+// Stereo output is appended to 'pcm' if not NULL. With 'timeSamples' set, the wall-clock time 
+// between consecutive samples (i.e. bus and emulation work of one sample period) is recorded.
+// With 'lateCore' set the core runs every 'drainInterval' cycles only, i.e. it renders samples late
+// (as on the device under load), which the sample FIFO has to absorb.
+//
+extern void replayBusTrace( const std::vector<BUSTRACE_EVENT> &events, int drainInterval, std::vector<int16_t> *pcm, ReplayResult &result, bool timeSamples = false, bool lateCore = false );
+
+extern bool writeWAV( const char *filename, const std::vector<int16_t> &pcm, uint32_t sampleRate );
+extern bool readWAV( const char *filename, std::vector<int16_t> &pcm );
+
+#endif
@@ -0,0 +1,152 @@
+//  ---------------------------------------------------------------------------
+//  This file is part of reSID, a MOS6581 SID emulator engine.
+//  SIDKick pico additions: Copyright (c) 2023-2025 Carsten Dachsbacher
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//  ---------------------------------------------------------------------------
+
+#ifndef __DSP_H__
+#define __DSP_H__
+
+#include <string.h>
+
+// ----------------------------------------------------------------------------
+// Saturation and dual 16-bit multiply-accumulate kernels for the filter and
+// output stages. With the DSP extension (Cortex-M33 of the RP2350 builds) they map
+// to SSAT, USAT and SMLAD; elsewhere (RP2040, host) the same operations are
+// written in C with identical results.
+// Each kernel has a _ref version, which is the plain C formulation it
+// replaces; skpico_kernels checks kernels and references for bit-exactness.
+// ----------------------------------------------------------------------------
+
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#define RESID_DSP 1
+#else
+#define RESID_DSP 0
+#endif
+
+// ----------------------------------------------------------------------------
+// Instructions.
+// ----------------------------------------------------------------------------
+
+// SSAT #16: saturate to [-32768, 32767].
+inline int dsp_ssat16(int x)
+{
+#if RESID_DSP
+  return __ssat(x, 16);
+#else
+  return x < -32768 ? -32768 : (x > 32767 ? 32767 : x);
+#endif
+}
+
+// USAT #8: saturate to [0, 255].
+inline int dsp_usat8(int x)
+{
+#if RESID_DSP
+  return (int)__usat(x, 8);
+#else
+  return x < 0 ? 0 : (x > 255 ? 255 : x);
+#endif
+}
+
+// Two adjacent 16-bit values as one word, p[0] in the lower half
+// (unaligned word loads are fine on the Cortex-M33).
+inline unsigned int dsp_load_pair(const short* p)
+{
+  unsigned int v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+// SMLAD: acc + x.lo*y.lo + x.hi*y.hi (signed 16-bit halves, wrapping sum).
+inline int dsp_smlad(unsigned int x, unsigned int y, int acc)
+{
+#if RESID_DSP
+  return __smlad(x, y, acc);
+#else
+  return (int)((unsigned int)acc
+    + (unsigned int)((short)x*(short)y)
+    + (unsigned int)((short)(x >> 16)*(short)(y >> 16)));
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Kernels: name_dsp is the formulation for the DSP extension (compiled on any
+// target for checking it), name_ref the plain C version, name selects one.
+// ----------------------------------------------------------------------------
+
+// Mixer output: the upper half of the mix, limited to [-32767, 32767].
+inline int dsp_mix_sat_dsp(int x)
+{
+  // SSAT with shifted operand, the lower limit is one less than SSAT's.
+  int y = dsp_ssat16(x >> 16);
+  return y < -32767 ? -32767 : y;
+}
+
+inline int dsp_mix_sat_ref(int x)
+{
+  x >>= 16;
+  if (x > 32767) x = 32767;
+  if (x < -32767) x = -32767;
+  return x;
+}
+
+inline int dsp_mix_sat(int x)
+{
+#if RESID_DSP
+  return dsp_mix_sat_dsp(x);
+#else
+  return dsp_mix_sat_ref(x);
+#endif
+}
+
+// Symmetric FIR: acc + sum h[j]*x[j] over an even number of taps with
+// h[j] = h[taps - 1 - j]. The DSP version takes two taps per SMLAD, without
+// it the symmetric halves are folded (one multiplication per pair of taps).
+inline int dsp_fir_sym_dsp(const short* x, const short* h, int taps, int acc)
+{
+  for (int j = 0; j < taps; j += 2) {
+    acc = dsp_smlad(dsp_load_pair(x + j), dsp_load_pair(h + j), acc);
+  }
+  return acc;
+}
+
+inline int dsp_fir_sym_folded(const short* x, const short* h, int taps, int acc)
+{
+  for (int j = 0; j < taps/2; j++) {
+    acc += h[j]*(x[j] + x[taps - 1 - j]);
+  }
+  return acc;
+}
+
+inline int dsp_fir_sym_ref(const short* x, const short* h, int taps, int acc)
+{
+  for (int j = 0; j < taps; j++) {
+    acc += h[j]*x[j];
+  }
+  return acc;
+}
+
+inline int dsp_fir_sym(const short* x, const short* h, int taps, int acc)
+{
+#if RESID_DSP
+  return dsp_fir_sym_dsp(x, h, taps, acc);
+#else
+  return dsp_fir_sym_folded(x, h, taps, acc);
+#endif
+}
+
+#endif // not __DSP_H__
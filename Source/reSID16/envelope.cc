@@ -211,6 +211,95 @@ void EnvelopeGenerator::reset()
 }
 
 
+// ----------------------------------------------------------------------------
+// Fast-forward over whole rate periods.
+// Advances by up to the given number of rate periods at once, as long as the
+// envelope counter does not reach a value where the exponential counter
+// period or the state changes (255, 93, 54, 26, 14, 6, 0) or the sustain
+// level. These are left to the period-by-period loop in clock(delta_t).
+// Returns the number of rate periods advanced.
+// ----------------------------------------------------------------------------
+int EnvelopeGenerator::fast_forward( int periods )
+{
+    int e = exponential_counter;
+    int e_period = exponential_counter_period;
+    int c = envelope_counter;
+
+    if ( new_exponential_counter_period || e >= e_period || state == FREEZED ) {
+        return 0;
+    }
+
+    if ( state == ATTACK ) {
+        // Each rate period resets the exponential counter and, unless frozen,
+        // increments the envelope counter.
+        exponential_counter = 0;
+        if ( hold_zero ) {
+            return periods;
+        }
+        int next = c < 0x06 ? 0x06 : c < 0x0e ? 0x0e : c < 0x1a ? 0x1a : c < 0x36 ? 0x36 : c < 0x5d ? 0x5d : 0xff;
+        if ( periods > next - c - 1 ) {
+            periods = next - c - 1;
+        }
+        if ( periods <= 0 ) {
+            exponential_counter = e;
+            return 0;
+        }
+        envelope_counter = c + periods;
+        return periods;
+    }
+
+    if ( hold_zero ) {
+        exponential_counter = ( e + periods ) % e_period;
+        return periods;
+    }
+
+    // Decay/sustain and release: the envelope counter is decremented on every
+    // e_period-th rate period.
+    int sustain_c = sustain_level[ sustain ];
+    int boundary = c > 0x5d ? 0x5d : c > 0x36 ? 0x36 : c > 0x1a ? 0x1a : c > 0x0e ? 0x0e : c > 0x06 ? 0x06 : c > 0x00 ? 0x00 : -1;
+
+    if ( state == DECAY_SUSTAIN && c == sustain_c ) {
+        // At the sustain level: only the exponential counter runs, unless
+        // the sustain level is a breakpoint.
+        if ( c == 0xff || c == 0x5d || c == 0x36 || c == 0x1a || c == 0x0e || c == 0x06 || c == 0x00 ) {
+            return 0;
+        }
+        exponential_counter = ( e + periods ) % e_period;
+        return periods;
+    }
+
+    if ( state == DECAY_SUSTAIN && sustain_c < c && sustain_c > boundary ) {
+        boundary = sustain_c;
+    }
+    if ( boundary < 0 ) {
+        return 0;
+    }
+
+    int steps_free = c - boundary - 1;
+    int first = e_period - e;           // rate periods to the first step
+
+    if ( periods < first ) {
+        exponential_counter = e + periods;
+        return periods;
+    }
+
+    int steps = 1 + ( periods - first ) / e_period;
+    if ( steps <= steps_free ) {
+        envelope_counter = c - steps;
+        exponential_counter = periods - first - ( steps - 1 ) * e_period;
+        return periods;
+    }
+
+    // Stop right after the last step before the boundary.
+    if ( !steps_free ) {
+        exponential_counter = e_period - 1;
+        return first - 1;
+    }
+    envelope_counter = c - steps_free;
+    exponential_counter = 0;
+    return first + ( steps_free - 1 ) * e_period;
+}
+
 // ----------------------------------------------------------------------------
 // Set chip model.
 // ----------------------------------------------------------------------------
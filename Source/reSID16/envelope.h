@@ -62,6 +62,7 @@ public:
 
 protected:
     void set_exponential_counter();
+    int fast_forward( int periods );
 
     void state_change();
 
@@ -239,6 +240,19 @@ void EnvelopeGenerator::clock( cycle_count delta_t )
     int rc = rate_counter;
     int dt = delta_t;
 
+    // Skip whole rate periods without envelope events at once; at least
+    // one cycle is left to the loop below, such that env3 is sampled as
+    // before.
+    int period = rate_period;   // NB! reg16 is unsigned
+    if ( unlikely( dt - rate_step > 2 * period ) ) {
+        int periods = fast_forward( 1 + ( dt - 1 - rate_step ) / period );
+        if ( periods ) {
+            dt -= rate_step + ( periods - 1 ) * period;
+            rc = 0;
+            rate_step = rate_period;
+        }
+    }
+
     while ( dt ) {
         // SIDKICK: this env3=... was missing, as a consequence reading 0x1c does not return (correct) values when emulating several cycles at once
         // The ENV3 value is sampled at the first phase of the clock
@@ -54,6 +54,7 @@ void ExternalFilter::setCutoffFrequencies( int highpassHz, int lowpassHz )
 void ExternalFilter::enable_filter(bool enable)
 {
   enabled = enable;
+  at_rest = false;
 }
 
 
@@ -72,6 +73,7 @@ void ExternalFilter::set_chip_model(chip_model model)
     // No DC offsets in the MOS8580.
     mixer_DC = 0;
   }
+  at_rest = false;
 }
 
 
@@ -84,4 +86,6 @@ void ExternalFilter::reset()
   Vlp = 0;
   Vhp = 0;
   Vo = 0;
+
+  at_rest = false;
 }
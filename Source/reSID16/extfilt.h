@@ -47,6 +47,11 @@ public:
 
   RESID_INLINE void clock(sound_sample Vi);
   RESID_INLINE void clock(cycle_count delta_t, sound_sample Vi);
+  // As above, the output of each step is passed to
+  // integrator.integrate(Vo, cycles) (SID16, SAMPLE_DECIMATE).
+  template<class Integrator>
+  RESID_INLINE void clock(cycle_count delta_t, sound_sample Vi,
+			  Integrator& integrator);
   void reset();
 
   // Audio output (20 bits).
@@ -68,6 +73,16 @@ protected:
   sound_sample w0lp;
   sound_sample w0hp;
 
+  // Filter state at a fixed point for the constant input rest_Vi.
+  bool at_rest;
+  sound_sample rest_Vi;
+
+  // clock(delta_t, Vi) does not integrate its output.
+  struct NoIntegrator
+  {
+    void integrate(sound_sample, cycle_count) {}
+  };
+
 friend class SID16;
 };
 
@@ -107,6 +122,8 @@ void ExternalFilter::clock(sound_sample Vi)
   Vo = Vlp - Vhp;
   Vlp += dVlp;
   Vhp += dVhp;
+
+  at_rest = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -115,14 +132,33 @@ void ExternalFilter::clock(sound_sample Vi)
 RESID_INLINE
 void ExternalFilter::clock(cycle_count delta_t,
 			   sound_sample Vi)
+{
+  NoIntegrator integrator;
+  clock(delta_t, Vi, integrator);
+}
+
+template<class Integrator>
+RESID_INLINE
+void ExternalFilter::clock(cycle_count delta_t,
+			   sound_sample Vi,
+			   Integrator& integrator)
 {
   // This is handy for testing.
   if (!enabled) {
     // Remove maximum DC level since there is no filter to do it.
     Vlp = Vhp = 0;
     Vo = Vi - mixer_DC;
+    integrator.integrate(Vo, delta_t);
+    return;
+  }
+
+  // The filter has settled for this input (e.g. a silent SID): the loop
+  // below would not change its state.
+  if (at_rest && Vi == rest_Vi) {
+    integrator.integrate(Vo, delta_t);
     return;
   }
+  at_rest = false;
 
   // Maximum delta cycles for the external filter to work satisfactorily
   // is approximately 8.
@@ -147,6 +183,16 @@ void ExternalFilter::clock(cycle_count delta_t,
     Vlp += dVlp;
     Vhp += dVhp;
 
+    // A full step leaving the state unchanged is a fixed point, shorter
+    // steps do not move it either.
+    if (delta_t_flt == 8 && !dVlp && !dVhp) {
+      at_rest = true;
+      rest_Vi = Vi;
+      integrator.integrate(Vo, delta_t);
+      return;
+    }
+
+    integrator.integrate(Vo, delta_t_flt);
     delta_t -= delta_t_flt;
   }
 }
@@ -159,6 +159,8 @@ Filter::Filter()
   Vlp = 0;
   Vnf = 0;
 
+  distortionStrength = 0;
+
   //enable_filter(true);
 
   if ( !f0Initialized )
@@ -261,6 +263,7 @@ void Filter::set6581FilterCoeffs( const signed short *preset, int minFreq, int m
 
     set_w0();
     set_Q();
+    select_clock_kernel();
 }
 
 // ----------------------------------------------------------------------------
@@ -308,6 +311,7 @@ void Filter::set_chip_model(chip_model model)
 
   set_w0();
   set_Q();
+  select_clock_kernel();
 }
 
 
@@ -336,6 +340,7 @@ void Filter::reset()
 
   set_w0();
   set_Q();
+  select_clock_kernel();
 }
 
 
@@ -360,6 +365,7 @@ void Filter::writeRES_FILT(reg8 res_filt)
   set_Q();
 
   filt = res_filt & 0x0f;
+  select_clock_kernel();
 }
 
 void Filter::writeMODE_VOL(reg8 mode_vol)
@@ -369,6 +375,51 @@ void Filter::writeMODE_VOL(reg8 mode_vol)
   hp_bp_lp = (mode_vol >> 4) & 0x07;
 
   vol = mode_vol & 0x0f;
+  select_clock_kernel();
+}
+
+// Select the clock kernel specialized for the current chip model, distortion
+// and routing, and set up the masks replacing the switches on filt and
+// hp_bp_lp.
+void Filter::select_clock_kernel()
+{
+  for (int i = 0; i < 4; i++) {
+    route_mask[i] = (filt >> i) & 1 ? ~0 : 0;
+  }
+  voice3_mask = (voice3off && !(filt & 0x04)) ? 0 : ~0;
+
+  for (int i = 0; i < 3; i++) {
+    mode_mask[i] = (hp_bp_lp >> i) & 1 ? ~0 : 0;
+  }
+
+  if (chipModel == MOS6581 && distortionStrength) {
+    clock_kernel = filt ? &Filter::clock_filter<MOS6581, true, true>
+			: &Filter::clock_filter<MOS6581, true, false>;
+  }
+  else if (chipModel == MOS6581) {
+    clock_kernel = filt ? &Filter::clock_filter<MOS6581, false, true>
+			: &Filter::clock_filter<MOS6581, false, false>;
+  }
+  else {
+    clock_kernel = filt ? &Filter::clock_filter<MOS8580, false, true>
+			: &Filter::clock_filter<MOS8580, false, false>;
+  }
+}
+
+// Dual SID clocking: the interleaved steps pay off for the 6581 distortion
+// model, with its table lookups per step. The plain kernels are short enough
+// to be stepped one filter after the other.
+bool Filter::clock_dual_interleaved(const Filter& f0, const Filter& f1)
+{
+  return f0.chipModel == MOS6581 && f0.distortionStrength &&
+	 f1.chipModel == MOS6581 && f1.distortionStrength;
+}
+
+// Dual SID clocking - delta_t cycles, see clock_filter_dual().
+void Filter::clock_dual(Filter& f0, Filter& f1, cycle_count delta_t,
+			const sound_sample* in0, const sound_sample* in1)
+{
+  clock_filter_dual<MOS6581, true>(f0, f1, delta_t, in0, in1);
 }
 
 // Set filter cutoff frequency.
@@ -390,6 +441,35 @@ void Filter::set_w0()
   // Limit f0 to 4kHz to keep delta_t cycle filter stable.
   const sound_sample w0_max_dt = static_cast<sound_sample>(2*pi*4000*1.048576);
   w0_ceil_dt = w0 <= w0_max_dt ? w0 : w0_max_dt;
+
+  // The 6581 distortion model at zero offset rounds differently.
+  const float pi_f = 3.1415926535897932385f;
+  const int c_w0_13 = static_cast<sound_sample>( 8192.0f * 2.0f * pi_f * 1.048576f );
+  sound_sample w0_13 = ( (int)f0[fc] * c_w0_13 ) >> 13;
+  w0_ceil_dt_6581 = w0_13 <= w0_max_dt ? w0_13 : w0_max_dt;
+
+  if (chipModel == MOS6581 && distortionStrength) {
+    set_w0_distortion();
+  }
+
+  at_rest = false;
+}
+
+// Tabulate the cutoff coefficients of the 6581 distortion model for the
+// current fc, i.e. for fc offset by 0..255 times the distortion strength.
+void Filter::set_w0_distortion()
+{
+  const float pi_f = 3.1415926535897932385f;
+  const int c_w0_13 = static_cast<sound_sample>( 8192.0f * 2.0f * pi_f * 1.048576f );
+  const sound_sample w0_max_dt = static_cast<sound_sample>(2*pi_f*4000*1.048576);
+
+  for (int i = 0; i < 256; i++) {
+    int fc_plus_offset = i * distortionStrength + fc;
+    if ( fc_plus_offset > 2047 ) fc_plus_offset = 2047;
+
+    int w0_dist = ( (int)f0[fc_plus_offset] * c_w0_13 ) >> 13;
+    w0_ceil_dt_dist[i] = w0_dist <= w0_max_dt ? w0_dist : w0_max_dt;
+  }
 }
 
 // Set filter resonance.
@@ -414,6 +494,8 @@ void Filter::set_Q()
   */
 
   _1024_div_Q = ( 10240000 / ( 7070 + 10000 * res / 0x0f ) );
+
+  at_rest = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -21,6 +21,7 @@
 #define __FILTER_H__
 
 #include "siddefs.h"
+#include "dsp.h"
 #include "spline.h"
 
 // ----------------------------------------------------------------------------
@@ -133,6 +134,12 @@ public:
   void clock(cycle_count delta_t,
   	     sound_sample voice1, sound_sample voice2, sound_sample voice3,
 	     sound_sample ext_in);
+  // Both filters of a dual SID, delta_t cycles: as f0.clock() followed by
+  // f1.clock(), in0/in1 are voice 1-3 and ext in of each chip. Only for
+  // filters with clock_dual_interleaved().
+  static bool clock_dual_interleaved(const Filter& f0, const Filter& f1);
+  static void clock_dual(Filter& f0, Filter& f1, cycle_count delta_t,
+			 const sound_sample* in0, const sound_sample* in1);
   void reset();
 
   // Write registers.
@@ -151,6 +158,7 @@ public:
   void set8580FilterCoeffs( int low, int center );
   void set6581FilterCoeffs( const signed short *preset, int minFreq, int maxFreq, int distortion );
   void set6581FilterCoeffsC( int preset, int minFreq, int maxFreq );
+  float evalType3( float br, float o, float s, float mfr, int x );
 
 protected:
   chip_model chipModel;
@@ -158,6 +166,53 @@ protected:
   void set_w0();
   void set_Q();
 
+  // Install the clock kernel and routing masks for the current state.
+  void select_clock_kernel();
+
+  template<chip_model model, bool distortion, bool routed>
+  void clock_filter(cycle_count delta_t,
+		    sound_sample voice1, sound_sample voice2, sound_sample voice3,
+		    sound_sample ext_in);
+  RESID_INLINE sound_sample w0_ceil_dt_distorted(sound_sample v);
+
+  // Filter input Vi for the given voices (Vnf is set to the unfiltered sum).
+  template<bool routed>
+  RESID_INLINE sound_sample route(sound_sample voice1, sound_sample voice2,
+				  sound_sample voice3, sound_sample ext_in);
+  // One integrator step of delta_t_flt <= 8 cycles on the state hp, bp, lp.
+  // Returns zero if the state did not change, a full step (8 cycles) is then
+  // at a fixed point for the input Vi.
+  template<chip_model model, bool distortion>
+  RESID_INLINE sound_sample clock_step(cycle_count delta_t_flt,
+				       sound_sample Vi, sound_sample& hp,
+				       sound_sample& bp, sound_sample& lp);
+  // The integrator steps of delta_t cycles for the input Vi.
+  template<chip_model model, bool distortion>
+  RESID_INLINE void clock_integrators(cycle_count delta_t, sound_sample Vi);
+  // clock_dual() for two filters with the same kernel, and its tail for
+  // either filter.
+  template<chip_model model, bool distortion>
+  static void clock_filter_dual(Filter& f0, Filter& f1, cycle_count delta_t,
+				const sound_sample* in0,
+				const sound_sample* in1);
+  template<chip_model model, bool distortion>
+  RESID_INLINE void finish_dual(cycle_count delta_t, sound_sample Vi,
+				bool settled);
+
+  typedef void (Filter::*ClockKernel)(cycle_count, sound_sample, sound_sample,
+				      sound_sample, sound_sample);
+  ClockKernel clock_kernel;
+
+  // Routing masks (voice 1-3, ext in), voice 3 mask for voice3off, and
+  // output masks (lowpass, bandpass, highpass): 0 or ~0.
+  sound_sample route_mask[4];
+  sound_sample voice3_mask;
+  sound_sample mode_mask[3];
+
+  // Filter state at a fixed point for the constant filter input rest_Vi.
+  bool at_rest;
+  sound_sample rest_Vi;
+
   // Filter enabled.
   //bool enabled;
 
@@ -190,6 +245,12 @@ protected:
 
   // Cutoff frequency, resonance.
   sound_sample w0, w0_ceil_1, w0_ceil_dt;
+  sound_sample w0_ceil_dt_6581; // as computed by the 6581 distortion model
+
+  // 6581 distortion: clamped cutoff coefficient per distortion offset
+  // for the current fc.
+  short w0_ceil_dt_dist[256];
+  void set_w0_distortion();
   sound_sample _1024_div_Q;
 
   int distortionStrength;
@@ -339,6 +400,8 @@ void Filter::clock(sound_sample voice1,
   Vbp -= dVbp;
   Vlp -= dVlp;
   Vhp = (Vbp*_1024_div_Q >> 10) - Vlp - Vi;
+
+  at_rest = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -351,229 +414,238 @@ void Filter::clock(cycle_count delta_t,
 		   sound_sample voice3,
 		   sound_sample ext_in)
 {
-  // Scale each voice down from 20 to 13 bits.
-//  voice1 >>= 7;
-//  voice2 >>= 7;
+  // The kernel matching chip model, distortion and routing is selected in
+  // select_clock_kernel() whenever one of them changes.
+  (this->*clock_kernel)(delta_t, voice1, voice2, voice3, ext_in);
+}
 
-  // NB! Voice 3 is not silenced by voice3off if it is routed through
-  // the filter.
-  if (voice3off && !(filt & 0x04)) {
-    voice3 = 0;
-  }
-  else {
-//    voice3 >>= 7;
-  }
+// ----------------------------------------------------------------------------
+// Cutoff coefficient of the 6581 distortion model, given the voltage v of
+// the integrator input (values from Jürgen Wothke's WebSid). The coefficients
+// for the current fc are tabulated in set_w0_distortion().
+// ----------------------------------------------------------------------------
+RESID_INLINE
+sound_sample Filter::w0_ceil_dt_distorted(sound_sample v)
+{
+  const sound_sample distortOfs = 87200;
+  //const sound_sample distortInvScale = static_cast<sound_sample>( 65536.0f * 2.0f / 117.2f );
+  const float distortScaleF = 99.7578f;
+  const sound_sample distortInvScale = static_cast<sound_sample>( 65536.0f * 2.0f / distortScaleF );
+  const sound_sample distortThreshold = 1134;
 
-//  ext_in >>= 7;
+  sound_sample v_distorted = ( ( (v<<3) + distortOfs ) * distortInvScale ) >> 16;  // 0..2047 + overflow
 
-  // Enable filter on/off.
-  // This is not really part of SID, but is useful for testing.
-  // On slow CPUs it may be necessary to bypass the filter to lower the CPU
-  // load.
-  /*if (!enabled) {
-    Vnf = voice1 + voice2 + voice3 + ext_in;
-    Vhp = Vbp = Vlp = 0;
-    return;
-  }*/
+  v_distorted = ( ( v_distorted + fc ) >> 1 ) - distortThreshold;
 
-  // Route voices into or around filter.
-  // The code below is expanded to a switch for faster execution.
-  // (filt1 ? Vi : Vnf) += voice1;
-  // (filt2 ? Vi : Vnf) += voice2;
-  // (filt3 ? Vi : Vnf) += voice3;
+  // optimized: index = v_distorted * 0.125, 0 for v_distorted <= 0
+  int i = dsp_usat8( v_distorted >> 2 );
 
-  sound_sample Vi;
+  return w0_ceil_dt_dist[ i ];
+}
 
-  // Vi = 0; Vnf = 0;
-  // if ( filt & 1 ) Vi += voice1; else Vnf += voice1;
-  // if ( filt & 2 ) Vi += voice2; else Vnf += voice2;
-  // if ( filt & 4 ) Vi += voice3; else Vnf += voice3;
-  // Vnf += ext_in;
+// ----------------------------------------------------------------------------
+// SID clocking - delta_t cycles, specialized on chip model, 6581 distortion
+// and whether any input is routed through the filter at all.
+// ----------------------------------------------------------------------------
+template<chip_model model, bool distortion, bool routed>
+void Filter::clock_filter(cycle_count delta_t,
+			  sound_sample voice1,
+			  sound_sample voice2,
+			  sound_sample voice3,
+			  sound_sample ext_in)
+{
+  sound_sample Vi = route<routed>(voice1, voice2, voice3, ext_in);
 
+  // The integrators have settled for this input (e.g. nothing routed or
+  // silent voices): the loop below would not change the filter state.
+  if (at_rest && Vi == rest_Vi) {
+    return;
+  }
 
-  switch (filt) {
-  default:
-  case 0x0:
-    Vi = 0;
-    Vnf = voice1 + voice2 + voice3 + ext_in;
-    break;
-  case 0x1:
-    Vi = voice1;
-    Vnf = voice2 + voice3 + ext_in;
-    break;
-  case 0x2:
-    Vi = voice2;
-    Vnf = voice1 + voice3 + ext_in;
-    break;
-  case 0x3:
-    Vi = voice1 + voice2;
-    Vnf = voice3 + ext_in;
-    break;
-  case 0x4:
-    Vi = voice3;
-    Vnf = voice1 + voice2 + ext_in;
-    break;
-  case 0x5:
-    Vi = voice1 + voice3;
-    Vnf = voice2 + ext_in;
-    break;
-  case 0x6:
-    Vi = voice2 + voice3;
-    Vnf = voice1 + ext_in;
-    break;
-  case 0x7:
-    Vi = voice1 + voice2 + voice3;
-    Vnf = ext_in;
-    break;
-  case 0x8:
-    Vi = ext_in;
-    Vnf = voice1 + voice2 + voice3;
-    break;
-  case 0x9:
-    Vi = voice1 + ext_in;
-    Vnf = voice2 + voice3;
-    break;
-  case 0xa:
-    Vi = voice2 + ext_in;
-    Vnf = voice1 + voice3;
-    break;
-  case 0xb:
-    Vi = voice1 + voice2 + ext_in;
-    Vnf = voice3;
-    break;
-  case 0xc:
-    Vi = voice3 + ext_in;
-    Vnf = voice1 + voice2;
-    break;
-  case 0xd:
-    Vi = voice1 + voice3 + ext_in;
-    Vnf = voice2;
-    break;
-  case 0xe:
-    Vi = voice2 + voice3 + ext_in;
-    Vnf = voice1;
-    break;
-  case 0xf:
-    Vi = voice1 + voice2 + voice3 + ext_in;
-    Vnf = 0;
-    break;
+  clock_integrators<model, distortion>(delta_t, Vi);
+}
+
+// ----------------------------------------------------------------------------
+// Filter input, routing of the voices into or around the filter.
+// ----------------------------------------------------------------------------
+template<bool routed>
+RESID_INLINE
+sound_sample Filter::route(sound_sample voice1,
+			   sound_sample voice2,
+			   sound_sample voice3,
+			   sound_sample ext_in)
+{
+  // NB! Voice 3 is not silenced by voice3off if it is routed through
+  // the filter.
+  voice3 &= voice3_mask;
+
+  // Route voices into or around filter. The routing masks replace the
+  // 16-way switch on filt, see select_clock_kernel().
+  sound_sample Vi = 0;
+  Vnf = voice1 + voice2 + voice3 + ext_in;
+
+  if (routed) {
+    Vi = (voice1 & route_mask[0]) + (voice2 & route_mask[1])
+       + (voice3 & route_mask[2]) + (ext_in & route_mask[3]);
+    Vnf -= Vi;
+    Vi >>= 7;
   }
 
-  Vi >>= 7;
   Vnf >>= 7;
 
+  return Vi;
+}
+
+// ----------------------------------------------------------------------------
+// Integrator steps for the filter input Vi.
+// ----------------------------------------------------------------------------
+template<chip_model model, bool distortion>
+RESID_INLINE
+void Filter::clock_integrators(cycle_count delta_t, sound_sample Vi)
+{
+  at_rest = false;
+
   // Maximum delta cycles for the filter to work satisfactorily under current
   // cutoff frequency and resonance constraints is approximately 8.
   cycle_count delta_t_flt = 8;
 
-  #define FILTER_WITH_DISTORTION
-
   while (delta_t) {
 
     if (delta_t < delta_t_flt) {
       delta_t_flt = delta_t;
     }
 
-    // delta_t is converted to seconds given a 1MHz clock by dividing
-    // with 1 000 000. This is done in two operations to avoid integer
-    // multiplication overflow.
-
-    // Calculate filter outputs.
-    // Vhp = Vbp/Q - Vlp - Vi;
-    // dVbp = -w0*Vhp*dt;
-    // dVlp = -w0*Vbp*dt;
-
-#ifdef FILTER_WITH_DISTORTION
-
-    sound_sample dVbp;
-    sound_sample dVlp;
-    
-    if ( chipModel == MOS6581) 
-    {
-        // values from Jürgen Wothke's WebSid
-        const sound_sample distortOfs = 87200;
-        //const sound_sample distortInvScale = static_cast<sound_sample>( 65536.0f * 2.0f / 117.2f );
-        const float distortScaleF = 99.7578f;
-        const sound_sample distortInvScale = static_cast<sound_sample>( 65536.0f * 2.0f / distortScaleF );
-        const sound_sample distortThreshold = 1134;
-
-        const sound_sample distortRescale = (256 * 65536 / 2048); // 0.125
-
-        int i;
+    // With constant input, a full step leaving the state unchanged is a
+    // fixed point: shorter steps scale w0_delta_t down and do not move it
+    // either.
+    if (!clock_step<model, distortion>(delta_t_flt, Vi, Vhp, Vbp, Vlp)
+	&& delta_t_flt == 8) {
+      at_rest = true;
+      rest_Vi = Vi;
+      return;
+    }
 
-        //
-        // compute w0_delta_t for dVbp (band pass update), i.e. from Vhp
-        //
-        sound_sample Vhp_distorted = ( ( (Vhp<<3) + distortOfs ) * distortInvScale ) >> 16;  // 1091..2047 + overflow
+    delta_t -= delta_t_flt;
+  }
+}
 
-        Vhp_distorted = ( ( Vhp_distorted + fc ) >> 1 ) - distortThreshold;
+template<chip_model model, bool distortion>
+RESID_INLINE
+sound_sample Filter::clock_step(cycle_count delta_t_flt, sound_sample Vi,
+				sound_sample& hp, sound_sample& bp,
+				sound_sample& lp)
+{
+  // delta_t is converted to seconds given a 1MHz clock by dividing
+  // with 1 000 000. This is done in two operations to avoid integer
+  // multiplication overflow.
 
-        if ( Vhp_distorted > 0 ) 
-        {		
-          // optimized
-          int index = Vhp_distorted >> 2;//( Vhp_distorted * distortRescale );
-          i = index < 256 ? index : 255;
-        } else
-          i = 0;
+  // Calculate filter outputs.
+  // Vhp = Vbp/Q - Vlp - Vi;
+  // dVbp = -w0*Vhp*dt;
+  // dVlp = -w0*Vbp*dt;
 
-        int fc_plus_offset = i * distortionStrength + fc;
-        if ( fc_plus_offset > 2047 ) fc_plus_offset = 2047;
+  sound_sample dVbp;
+  sound_sample dVlp;
+
+  if (distortion) {
+    // w0_delta_t for dVbp (band pass update) depends on Vhp,
+    // w0_delta_t for dVlp (low pass update) depends on Vbp.
+    sound_sample w0_delta_t_Vhp = w0_ceil_dt_distorted(hp) * delta_t_flt >> 6;
+    sound_sample w0_delta_t_Vbp = w0_ceil_dt_distorted(bp) * delta_t_flt >> 6;
+
+    dVbp = (w0_delta_t_Vhp*hp >> 14);
+    dVlp = (w0_delta_t_Vbp*bp >> 14);
+  } else {
+    // Cutoff coefficient used when the cutoff frequency does not depend on
+    // the filter state. The 6581 without distortion uses the coefficient of
+    // the distortion model at zero offset.
+    const sound_sample w0_dt = model == MOS6581 ? w0_ceil_dt_6581 : w0_ceil_dt;
+    sound_sample w0_delta_t = w0_dt*delta_t_flt >> 6;
+    dVbp = (w0_delta_t*hp >> 14);
+    dVlp = (w0_delta_t*bp >> 14);
+  }
 
-        const float pi = 3.1415926535897932385f;
-        const int c_w0_13 = static_cast<sound_sample>( 8192.0f * 2.0f * pi * 1.048576f );
+  sound_sample Vhp_prev = hp;
 
-        int w0 = ( (int)f0[fc_plus_offset] * c_w0_13 ) >> 13;
+  bp -= dVbp;
+  lp -= dVlp;
+  hp = (bp*_1024_div_Q >> 10) - lp - Vi;
 
-        const sound_sample w0_max_dt = static_cast<sound_sample>(2*pi*4000*1.048576);
+  return dVbp | dVlp | (hp ^ Vhp_prev);
+}
 
-        int w0_ceil_dt_Vhp = w0 <= w0_max_dt ? w0 : w0_max_dt;
+// ----------------------------------------------------------------------------
+// Dual SID clocking - delta_t cycles, both filters with the same chip model
+// and distortion. The steps of the two filters are interleaved in one loop,
+// their state is held as arrays indexed by chip. Routing always goes through
+// the masks, which gives the same Vi and Vnf as the unrouted kernels for
+// filt = 0.
+// ----------------------------------------------------------------------------
+template<chip_model model, bool distortion>
+void Filter::clock_filter_dual(Filter& f0, Filter& f1, cycle_count delta_t,
+			       const sound_sample* in0,
+			       const sound_sample* in1)
+{
+  sound_sample Vi[2];
+  Vi[0] = f0.route<true>(in0[0], in0[1], in0[2], in0[3]);
+  Vi[1] = f1.route<true>(in1[0], in1[1], in1[2], in1[3]);
+
+  bool rest0 = f0.at_rest && Vi[0] == f0.rest_Vi;
+  bool rest1 = f1.at_rest && Vi[1] == f1.rest_Vi;
+  if (rest0 || rest1) {
+    if (!rest0) {
+      f0.clock_integrators<model, distortion>(delta_t, Vi[0]);
+    }
+    if (!rest1) {
+      f1.clock_integrators<model, distortion>(delta_t, Vi[1]);
+    }
+    return;
+  }
 
-        sound_sample w0_delta_t_Vhp = w0_ceil_dt_Vhp * delta_t_flt >> 6;
+  sound_sample Vhp[2] = { f0.Vhp, f1.Vhp };
+  sound_sample Vbp[2] = { f0.Vbp, f1.Vbp };
+  sound_sample Vlp[2] = { f0.Vlp, f1.Vlp };
+  sound_sample moved[2] = { 1, 1 };
 
-        //
-        // compute w0_delta_t for dVlp (low pass update), i.e. from Vbp
-        //
-        sound_sample Vbp_distorted = ( ( (Vbp<<3) + distortOfs ) * distortInvScale ) >> 16;  // 0..2047 + overflow
+  cycle_count delta_t_flt = 8;
 
-        Vbp_distorted = ( ( Vbp_distorted + fc ) >> 1 ) - distortThreshold;
+  while (delta_t) {
 
-        if ( Vbp_distorted > 0 ) 
-        {		
-          // optimized
-          int index = Vbp_distorted >> 2;//( Vbp_distorted * distortRescale );
-          i = index < 256 ? index : 255;
-        } else
-          i = 0;
+    if (delta_t < delta_t_flt) {
+      delta_t_flt = delta_t;
+    }
 
-        fc_plus_offset = i * distortionStrength + fc;
-        if ( fc_plus_offset > 2047 ) fc_plus_offset = 2047;
+    moved[0] = f0.clock_step<model, distortion>(delta_t_flt, Vi[0], Vhp[0], Vbp[0], Vlp[0]);
+    moved[1] = f1.clock_step<model, distortion>(delta_t_flt, Vi[1], Vhp[1], Vbp[1], Vlp[1]);
 
-        w0 = ( (int)f0[fc_plus_offset] * c_w0_13 ) >> 13;
+    delta_t -= delta_t_flt;
 
-        int w0_ceil_dt_Vbp = w0 <= w0_max_dt ? w0 : w0_max_dt;
+    if ((!moved[0] || !moved[1]) && delta_t_flt == 8) {
+      break;
+    }
+  }
 
-        sound_sample w0_delta_t_Vbp = w0_ceil_dt_Vbp * delta_t_flt >> 6;
+  f0.Vhp = Vhp[0]; f0.Vbp = Vbp[0]; f0.Vlp = Vlp[0];
+  f1.Vhp = Vhp[1]; f1.Vbp = Vbp[1]; f1.Vlp = Vlp[1];
 
-        sound_sample w0_delta_t = w0_ceil_dt*delta_t_flt >> 6;
+  f0.finish_dual<model, distortion>(delta_t, Vi[0], !moved[0] && delta_t_flt == 8);
+  f1.finish_dual<model, distortion>(delta_t, Vi[1], !moved[1] && delta_t_flt == 8);
+}
 
-        dVbp = (w0_delta_t_Vhp*Vhp >> 14);
-        dVlp = (w0_delta_t_Vbp*Vbp >> 14);
-    } else
-    {
-        sound_sample w0_delta_t = w0_ceil_dt*delta_t_flt >> 6;
-        dVbp = (w0_delta_t*Vhp >> 14);
-        dVlp = (w0_delta_t*Vbp >> 14);
+// A filter at its fixed point is done, the other one takes the remaining
+// steps of clock_filter_dual() on its own.
+template<chip_model model, bool distortion>
+RESID_INLINE
+void Filter::finish_dual(cycle_count delta_t, sound_sample Vi, bool settled)
+{
+  if (settled) {
+    at_rest = true;
+    rest_Vi = Vi;
+  } else {
+    at_rest = false;
+    if (delta_t) {
+      clock_integrators<model, distortion>(delta_t, Vi);
     }
-#else
-    sound_sample w0_delta_t = w0_ceil_dt*delta_t_flt >> 6;
-    sound_sample dVbp = (w0_delta_t*Vhp >> 14);
-    sound_sample dVlp = (w0_delta_t*Vbp >> 14);
-#endif
-    Vbp -= dVbp;
-    Vlp -= dVlp;
-    Vhp = (Vbp*_1024_div_Q >> 10) - Vlp - Vi;
-
-    delta_t -= delta_t_flt;
   }
 }
 
@@ -593,40 +665,12 @@ sound_sample Filter::output()
   // weighted, this can be confirmed by sampling sound output for
   // e.g. bandpass, lowpass, and bandpass+lowpass from a SID chip.
 
-  // The code below is expanded to a switch for faster execution.
+  // The code below is expanded to masks set in select_clock_kernel().
   // if (hp) Vf += Vhp;
   // if (bp) Vf += Vbp;
   // if (lp) Vf += Vlp;
 
-  sound_sample Vf;
-
-  switch (hp_bp_lp) {
-  default:
-  case 0x0:
-    Vf = 0;
-    break;
-  case 0x1:
-    Vf = Vlp;
-    break;
-  case 0x2:
-    Vf = Vbp;
-    break;
-  case 0x3:
-    Vf = Vlp + Vbp;
-    break;
-  case 0x4:
-    Vf = Vhp;
-    break;
-  case 0x5:
-    Vf = Vlp + Vhp;
-    break;
-  case 0x6:
-    Vf = Vbp + Vhp;
-    break;
-  case 0x7:
-    Vf = Vlp + Vbp + Vhp;
-    break;
-  }
+  sound_sample Vf = (Vlp & mode_mask[0]) + (Vbp & mode_mask[1]) + (Vhp & mode_mask[2]);
 
   // Sum non-filtered and filtered output.
   // Multiply the sum with volume.
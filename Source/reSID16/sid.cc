@@ -48,6 +48,11 @@ __attribute__( ( optimize( "Os" ) ) ) SID16::SID16()
   #endif
 
   ext_in = 0;
+
+  wave_deferred = 0;
+
+  accuracy = ACCURACY_DELTA;
+  cycles_exact = 0;
 }
 
 
@@ -66,6 +71,8 @@ SID16::~SID16()
 // ----------------------------------------------------------------------------
 void __attribute__( ( optimize( "Os" ) ) ) SID16::set_chip_model(chip_model model)
 {
+  flush_waveform_output(wave_deferred);
+
   for (int i = 0; i < 3; i++) {
     voice[i].set_chip_model(model);
   }
@@ -75,6 +82,16 @@ void __attribute__( ( optimize( "Os" ) ) ) SID16::set_chip_model(chip_model mode
 }
 
 
+// ----------------------------------------------------------------------------
+// Set emulation accuracy.
+// ----------------------------------------------------------------------------
+void SID16::set_accuracy(accuracy_tier tier)
+{
+  accuracy = tier;
+  cycles_exact = 0;
+}
+
+
 // ----------------------------------------------------------------------------
 // SID reset.
 // ----------------------------------------------------------------------------
@@ -85,12 +102,32 @@ void __attribute__( ( optimize( "Os" ) ) ) SID16::reset()
     forceOutput[ i ] = 0;
   }
   v0p = 0;
+  wave_deferred = 0;
 
   filter.reset();
   extfilt.reset();
 
   bus_value = 0;
   bus_value_ttl = 0;
+
+  render_pending = 0;
+
+  reset_decimation();
+}
+
+
+// ----------------------------------------------------------------------------
+// Power-on state: reset() keeps the oscillator accumulators and envelope
+// counters as the chip does, here they are set to their power-up values.
+// ----------------------------------------------------------------------------
+void __attribute__( ( optimize( "Os" ) ) ) SID16::power_on()
+{
+  for (int i = 0; i < 3; i++) {
+    voice[i].wave.accumulator = 0x555555;
+    voice[i].wave.tri_saw_pipeline = 0x555;
+    voice[i].envelope.envelope_counter = 0xaa;
+  }
+  reset();
 }
 
 
@@ -119,15 +156,9 @@ void SID16::forceDigiOutput( int voice, int value )
 int SID16::output()
 {
   const int range = 1 << 16;
-  const int half = range >> 1;
-  int sample = extfilt.output()/((4095*255 >> 7)*3*15*2/range) + (v0p<<0);
-  if (sample >= half) {
-    return half - 1;
-  }
-  if (sample < -half) {
-    return -half;
-  }
-  return sample;
+  int sample = sampling == SAMPLE_DECIMATE ? output_decimated() :
+    extfilt.output()/((4095*255 >> 7)*3*15*2/range) + (v0p<<0);
+  return dsp_ssat16(sample);
 }
 
 int SID16::output(int bits)
@@ -162,8 +193,26 @@ int SID16::output(int bits)
 // value instead). With this in mind we return the last value written to
 // any SID register for $2000 cycles without modeling the bit fading.
 // ----------------------------------------------------------------------------
+
+// Calculate deferred waveform outputs before they are observed (OSC3) or
+// a register write changes the state they depend on.
+RESID_INLINE
+void SID16::flush_waveform_output(reg8 voices)
+{
+  voices &= wave_deferred;
+  if ( voices ) {
+    for ( int i = 0; i < 3; i++ ) {
+      if ( voices & ( 1 << i ) ) {
+        voice[ i ].wave.set_waveform_output( 0 );
+      }
+    }
+    wave_deferred &= ~voices;
+  }
+}
+
 void SID16::readRegisters( unsigned char *p )
 {
+  flush_waveform_output( 1 << 2 );
   p[ 0 ] = voice[2].wave.readOSC();
   p[ 1 ] = voice[2].envelope.readENV();
 }
@@ -176,6 +225,7 @@ reg8 SID16::read(reg8 offset)
   //case 0x1a:
     //return poty.readPOT();
   case 0x1b:
+    flush_waveform_output( 1 << 2 );
     return voice[2].wave.readOSC();
   case 0x1c:
     return voice[2].envelope.readENV();
@@ -184,6 +234,38 @@ reg8 SID16::read(reg8 offset)
   }
 }
 
+// ----------------------------------------------------------------------------
+// OSC3/ENV3 as they will read at n points 'step' cycles apart, starting now,
+// if no register is written in between. Copies of the voices are clocked, the
+// state of the chip does not change.
+// ----------------------------------------------------------------------------
+void SID16::predictVoice3(unsigned char* osc3, unsigned char* env3, int n, cycle_count step)
+{
+  flush_waveform_output( 1 << 2 );
+
+  Voice v[ 3 ] = { voice[ 0 ], voice[ 1 ], voice[ 2 ] };
+  v[ 0 ].set_sync_source( &v[ 2 ] );
+  v[ 1 ].set_sync_source( &v[ 0 ] );
+  v[ 2 ].set_sync_source( &v[ 1 ] );
+
+  for ( int k = 0; ; k++ ) {
+      osc3[ k ] = v[ 2 ].wave.readOSC();
+      env3[ k ] = v[ 2 ].envelope.readENV();
+      if ( k + 1 == n ) {
+          break;
+      }
+      v[ 2 ].envelope.clock( step );
+      clock_oscillators( v, step );
+      // as in clock_voices(): combined waveforms write back to the
+      // oscillators, which matters for voice 3 via sync/ring modulation
+      for ( int i = 0; i < 3; i++ ) {
+          if ( i == 2 || !v[ i ].wave.waveform_output_is_pure() ) {
+              v[ i ].wave.set_waveform_output( step );
+          }
+      }
+  }
+}
+
 
 // ----------------------------------------------------------------------------
 // Write registers.
@@ -193,6 +275,8 @@ void SID16::write(reg8 offset, reg8 value)
   bus_value = value;
   bus_value_ttl = 0x2000;
 
+  flush_waveform_output( wave_deferred );
+
   switch (offset) {
   case 0x00:
     voice[0].wave.writeFREQ_LO(value);
@@ -499,6 +583,14 @@ bool SID16::set_sampling_parameters(float clock_freq, sampling_method method,
   sample_offset = 0;
   sample_prev = 0;
 
+  render_phase = 0;
+  render_pending = 0;
+  render_step = int(sample_freq + 0.5);
+  render_period = int(clock_freq + 0.5);
+
+  decim_period = cycles_per_sample >> 2;
+  reset_decimation();
+
   // FIR initialization is only necessary for resampling.
   if (method != SAMPLE_RESAMPLE_INTERPOLATE && method != SAMPLE_RESAMPLE_FAST)
   {
@@ -611,6 +703,7 @@ void SID16::adjust_sampling_frequency(float sample_freq)
 {
   cycles_per_sample =
     cycle_count(clock_frequency/sample_freq*(1 << FIXP_SHIFT) + 0.5);
+  decim_period = cycles_per_sample >> 2;
 }
 
 
@@ -825,33 +918,155 @@ void SID16::clock(cycle_count delta_t)
   // Clock external filter.
   extfilt.clock(delta_t, filter.output() );
 #endif
-  int i;
+  clock_chip( delta_t );
+}
 
-  // Pipelined writes on the MOS8580.
-/*  if ( ( write_pipeline ) && ( delta_t > 0 ) ) {
-      // Step one cycle by a recursive call to ourselves.
-      write_pipeline = 0;
-      clock( 1 );
-      write();
-      delta_t -= 1;
-  }*/
+RESID_INLINE
+void SID16::clock_chip(cycle_count delta_t)
+{
+  if ( ( accuracy != ACCURACY_DELTA ) && ( accuracy == ACCURACY_CYCLE || clock_exact_needed() ) ) {
+      clock_exact( delta_t );
+      return;
+  }
 
-#if 0
-  if ( ( delta_t <= 0 ) ) {
+  if ( sampling == SAMPLE_DECIMATE ) {
+      clock_decimate( delta_t );
       return;
   }
 
-  // Age bus value.
-  bus_value_ttl -= delta_t;
-  if ( ( bus_value_ttl <= 0 ) ) {
-      bus_value = 0;
-      bus_value_ttl = 0;
+  clock_voices(delta_t);
+  clock_filters(delta_t);
+}
+
+RESID_INLINE
+bool SID16::clock_delta_path()
+{
+  return !( ( accuracy != ACCURACY_DELTA ) && ( accuracy == ACCURACY_CYCLE || clock_exact_needed() ) )
+         && sampling != SAMPLE_DECIMATE;
+}
+
+// ----------------------------------------------------------------------------
+// Dual SID clocking - delta_t cycles.
+// ----------------------------------------------------------------------------
+void DualSID16::clock(cycle_count delta_t)
+{
+  bool delta0 = sid[ 0 ].clock_delta_path();
+  bool delta1 = sid[ 1 ].clock_delta_path();
+
+  // A chip clocked cycle by cycle or with decimation takes its own path, as
+  // do both chips unless their filters are stepped together.
+  if ( !( delta0 && delta1 && Filter::clock_dual_interleaved( sid[ 0 ].filter, sid[ 1 ].filter ) ) ) {
+      for ( int c = 0; c < 2; c++ ) {
+          if ( c ? delta1 : delta0 ) {
+              sid[ c ].clock_voices( delta_t );
+              sid[ c ].clock_filters( delta_t );
+          } else {
+              sid[ c ].clock_chip( delta_t );
+          }
+      }
+      return;
   }
-#endif
 
   // Clock amplitude modulators.
+  for ( int i = 0; i < 3; i++ ) {
+      sid[ 0 ].voice[ i ].envelope.clock( delta_t );
+      sid[ 1 ].voice[ i ].envelope.clock( delta_t );
+  }
+
+  sid[ 0 ].clock_waveforms( delta_t );
+  sid[ 1 ].clock_waveforms( delta_t );
+
+  sound_sample in0[ 4 ], in1[ 4 ];
+  sid[ 0 ].filter_inputs( in0 );
+  sid[ 1 ].filter_inputs( in1 );
+
+  Filter::clock_dual( sid[ 0 ].filter, sid[ 1 ].filter, delta_t, in0, in1 );
+
+  // Not decimating: the external filters are clocked as in clock_extfilt().
+  sid[ 0 ].extfilt.clock( delta_t, sid[ 0 ].filter.output() );
+  sid[ 1 ].extfilt.clock( delta_t, sid[ 1 ].filter.output() );
+}
+
+// ----------------------------------------------------------------------------
+// ACCURACY_HYBRID: single cycle clocking is required where clock(delta_t)
+// deviates, i.e. for combined waveforms (write back to the accumulator and
+// the shift register, 8580 tri/saw pipeline) and for hard sync.
+// ----------------------------------------------------------------------------
+RESID_INLINE
+bool SID16::clock_exact_needed()
+{
+  for ( int i = 0; i < 3; i++ ) {
+      const WaveformGenerator& wave = voice[ i ].wave;
+      if ( ( wave.waveform & ( wave.waveform - 1 ) ) || ( wave.sync && wave.sync_source->freq ) ) {
+          return true;
+      }
+  }
+  return false;
+}
+
+// ----------------------------------------------------------------------------
+// SID clocking - delta_t single cycles.
+// ----------------------------------------------------------------------------
+void SID16::clock_exact(cycle_count delta_t)
+{
+  int i;
+
+  if ( delta_t <= 0 ) {
+      return;
+  }
+
+  cycles_exact += delta_t;
+
+  // The waveform output is calculated on every cycle.
+  wave_deferred = 0;
+
+  while ( delta_t-- ) {
+      // Clock amplitude modulators.
+      for ( i = 0; i < 3; i++ ) {
+          voice[ i ].envelope.clock();
+      }
+
+      // Clock oscillators.
+      for ( i = 0; i < 3; i++ ) {
+          voice[ i ].wave.clock();
+      }
+
+      // Synchronize oscillators.
+      for ( i = 0; i < 3; i++ ) {
+          voice[ i ].wave.synchronize();
+      }
+
+      // Calculate waveform output.
+      for ( i = 0; i < 3; i++ ) {
+          voice[ i ].wave.set_waveform_output();
+      }
+
+      clock_filters( 1 );
+  }
+
+  // Hard sync scheduling of clock(delta_t) restarts from the current
+  // accumulators.
   for ( i = 0; i < 3; i++ ) {
-      voice[ i ].envelope.clock( delta_t );
+      voice[ i ].wave.msb_next = 0;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// Clock and synchronize the oscillators of three voices (of this SID, or the
+// copies of predictVoice3()).
+// ----------------------------------------------------------------------------
+RESID_INLINE
+void SID16::clock_oscillators(Voice* voice, cycle_count delta_t)
+{
+  int i;
+
+  // It is only necessary to clock on the MSB of an oscillator that is
+  // a sync source and has freq != 0.
+  int sync_sources = 0;
+  for ( i = 0; i < 3; i++ ) {
+      if ( voice[ i ].wave.sync_dest->sync && voice[ i ].wave.freq ) {
+          sync_sources |= 1 << i;
+      }
   }
 
   // Clock and synchronize oscillators.
@@ -862,36 +1077,23 @@ void SID16::clock(cycle_count delta_t)
 
       // Find minimum number of cycles to an oscillator accumulator MSB toggle.
       // We have to clock on each MSB on / MSB off for hard sync to operate
-      // correctly.
+      // correctly. The toggle cycles are scheduled without division unless
+      // an accumulator has been reset (see msb_toggle_cycles()).
       for ( i = 0; i < 3; i++ ) {
-          WaveformGenerator &wave = voice[ i ].wave;
-
-          // It is only necessary to clock on the MSB of an oscillator that is
-          // a sync source and has freq != 0.
-          if ( ( !( wave.sync_dest->sync && wave.freq ) ) ) {
-              continue;
-          }
-
-          reg16 freq = wave.freq;
-          reg24 accumulator = wave.accumulator;
-
-          // Clock on MSB off if MSB is on, clock on MSB on if MSB is off.
-          reg24 delta_accumulator =
-              ( accumulator & 0x800000 ? 0x1000000 : 0x800000 ) - accumulator;
-
-          cycle_count delta_t_next = delta_accumulator / freq;
-          if ( ( delta_accumulator % freq ) ) {
-              ++delta_t_next;
-          }
-
-          if ( ( delta_t_next < delta_t_min ) ) {
-              delta_t_min = delta_t_next;
+          if ( sync_sources & ( 1 << i ) ) {
+              cycle_count delta_t_next = voice[ i ].wave.msb_toggle_cycles();
+              if ( ( delta_t_next < delta_t_min ) ) {
+                  delta_t_min = delta_t_next;
+              }
           }
       }
 
       // Clock oscillators.
       for ( i = 0; i < 3; i++ ) {
           voice[ i ].wave.clock( delta_t_min );
+          if ( sync_sources & ( 1 << i ) ) {
+              voice[ i ].wave.msb_toggle_advance( delta_t_min );
+          }
       }
 
       // Synchronize oscillators.
@@ -901,10 +1103,106 @@ void SID16::clock(cycle_count delta_t)
 
       delta_t_osc -= delta_t_min;
   }
+}
+
+
+// ----------------------------------------------------------------------------
+// SID clocking - delta_t cycles: envelopes and oscillators.
+// ----------------------------------------------------------------------------
+RESID_INLINE
+void SID16::clock_voices(cycle_count delta_t)
+{
+  int i;
+
+  // Pipelined writes on the MOS8580.
+/*  if ( ( write_pipeline ) && ( delta_t > 0 ) ) {
+      // Step one cycle by a recursive call to ourselves.
+      write_pipeline = 0;
+      clock( 1 );
+      write();
+      delta_t -= 1;
+  }*/
+
+#if 0
+  if ( ( delta_t <= 0 ) ) {
+      return;
+  }
+
+  // Age bus value.
+  bus_value_ttl -= delta_t;
+  if ( ( bus_value_ttl <= 0 ) ) {
+      bus_value = 0;
+      bus_value_ttl = 0;
+  }
+#endif
+
+  // Clock amplitude modulators.
+  for ( i = 0; i < 3; i++ ) {
+      voice[ i ].envelope.clock( delta_t );
+  }
+
+  clock_waveforms( delta_t );
+}
+
+// ----------------------------------------------------------------------------
+// SID clocking - delta_t cycles: oscillators and waveform outputs.
+// ----------------------------------------------------------------------------
+RESID_INLINE
+void SID16::clock_waveforms(cycle_count delta_t)
+{
+  int i;
+
+  clock_oscillators( voice, delta_t );
 
   // Calculate waveform output.
+  // A voice with zero envelope output only contributes its DC offset. Unless
+  // the waveform output writes back to the oscillator state it is calculated
+  // when it is observed next, see flush_waveform_output().
+  wave_deferred = 0;
   for ( i = 0; i < 3; i++ ) {
-      voice[ i ].wave.set_waveform_output( delta_t );
+      if ( !voice[ i ].envelope.envelope_counter && voice[ i ].wave.waveform_output_is_pure() ) {
+          wave_deferred |= 1 << i;
+      } else {
+          voice[ i ].wave.set_waveform_output( delta_t );
+      }
+  }
+}
+
+// ----------------------------------------------------------------------------
+// SID clocking - delta_t cycles: voice outputs, filter and external filter.
+// ----------------------------------------------------------------------------
+RESID_INLINE
+void SID16::clock_filters(cycle_count delta_t)
+{
+  sound_sample in[ 4 ];
+  filter_inputs( in );
+
+  // Clock filter.
+  filter.clock( delta_t, in[ 0 ], in[ 1 ], in[ 2 ], in[ 3 ] );
+  // Clock external filter.
+  clock_extfilt( delta_t );
+}
+
+// ----------------------------------------------------------------------------
+// Filter inputs (voice 1-3, ext in) for the current voice outputs and digi
+// output.
+// ----------------------------------------------------------------------------
+RESID_INLINE
+void SID16::filter_inputs(sound_sample* in)
+{
+  // Quiescent chip: all envelopes at zero, no external input, no digi output.
+  // The filters see constant input and skip their integrators once settled.
+  if ( !( voice[ 0 ].envelope.envelope_counter | voice[ 1 ].envelope.envelope_counter | voice[ 2 ].envelope.envelope_counter )
+       && !ext_in && !( forceOutput[ 0 ] | forceOutput[ 1 ] | forceOutput[ 2 ] ) ) {
+      v0p = 0;
+#ifdef USE_RGB_LED
+      voiceOut[ 0 ] = voiceOut[ 1 ] = voiceOut[ 2 ] = 0;
+#endif
+      in[ 0 ] = voice[ 0 ].voice_DC;
+      in[ 1 ] = voice[ 1 ].voice_DC;
+      in[ 2 ] = voice[ 2 ].voice_DC;
+      in[ 3 ] = 0;
+      return;
   }
 
   int v0 = voice[ 0 ].output();
@@ -951,10 +1249,134 @@ void SID16::clock(cycle_count delta_t)
 
 #endif
 
-  // Clock filter.
-  filter.clock( delta_t, v0, v1, v2, ext_in );
-  // Clock external filter.
-  extfilt.clock( delta_t, filter.output() );  
+  in[ 0 ] = v0;
+  in[ 1 ] = v1;
+  in[ 2 ] = v2;
+  in[ 3 ] = ext_in;
+}
+
+RESID_INLINE
+void SID16::clock_extfilt(cycle_count delta_t)
+{
+  if ( sampling == SAMPLE_DECIMATE ) {
+      extfilt.clock( delta_t, filter.output(), *this );
+  } else {
+      extfilt.clock( delta_t, filter.output() );
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+// Band-limited output (SAMPLE_DECIMATE).
+// Half-band filters (Kaiser window, Q14): the center tap is 1/2, every other
+// tap is zero, the nonzero taps besides the center are listed (for
+// dsp_fir_sym(), aligned for pairwise reads).
+// Stage 1 (11 taps):  < 0.01dB to 20kHz, > 42dB rejection above 68.2kHz.
+// Stage 2 (39 taps):  < 0.05dB to 18kHz, > 46dB rejection above 26.1kHz
+// (frequencies for 44.1kHz output).
+// ----------------------------------------------------------------------------
+alignas(4) static const short decim_h1[6] = { 93, -889, 4892, 4892, -889, 93 };
+alignas(4) static const short decim_h2[20] = {
+  -4, 17, -45, 94, -174, 303, -508, 860, -1623, 5176,
+  5176, -1623, 860, -508, 303, -174, 94, -45, 17, -4 };
+
+void SID16::reset_decimation()
+{
+  decim_frac = 0;
+  decim_left = decim_len = 1;
+  decim_sum = 0;
+  decim_phase = 0;
+  decim_p2 = 0;
+  for (int p = 0; p < 2; p++) {
+    decim_i1[p] = decim_i2[p] = 0;
+    for (int i = 0; i < 2*DECIM_T1; i++) {
+      decim_x1[p][i] = 0;
+    }
+    for (int i = 0; i < 2*DECIM_T2; i++) {
+      decim_x2[p][i] = 0;
+    }
+  }
+}
+
+// The envelopes are clocked in one go, the oscillators and the filters up to
+// each sub-sample boundary, i.e. the waveforms are sampled at 4x the sample
+// frequency.
+void SID16::clock_decimate(cycle_count delta_t)
+{
+  for ( int i = 0; i < 3; i++ ) {
+      voice[ i ].envelope.clock( delta_t );
+  }
+
+  while ( delta_t > 0 ) {
+      cycle_count n = delta_t < decim_left ? delta_t : decim_left;
+      clock_waveforms( n );
+      clock_filters( n );
+      delta_t -= n;
+  }
+}
+
+// The external filter passes its output for each of its steps, which is
+// integrated up to the sub-sample boundaries (boxcar).
+RESID_INLINE
+void SID16::integrate(sound_sample Vo, cycle_count delta_t)
+{
+  const int range = 1 << 16;
+  Vo += v0p*((4095*255 >> 7)*3*15*2/range);
+
+  while ( delta_t >= decim_left ) {
+      decim_sum += Vo*decim_left;
+      delta_t -= decim_left;
+      decimate();
+  }
+  decim_sum += Vo*delta_t;
+  decim_left -= delta_t;
+}
+
+// At a sub-sample boundary the average output over the sub-sample period is
+// fed to the first half-band filter.
+void SID16::decimate()
+{
+  const int range = 1 << 16;
+
+  int x = dsp_ssat16(decim_sum/(decim_len*((4095*255 >> 7)*3*15*2/range)));
+  decim_sum = 0;
+
+  decim_frac += decim_period;
+  decim_left = decim_len = decim_frac >> FIXP_SHIFT;
+  decim_frac &= FIXP_MASK;
+
+  // The first stage outputs with every second input: its nonzero taps
+  // are these inputs (buffer 0), the center tap 5 inputs back is the
+  // third newest of the others (buffer 1).
+  decim_phase ^= 1;
+  int& i1 = decim_i1[decim_phase];
+  i1 = i1 ? i1 - 1 : DECIM_T1 - 1;
+  decim_x1[decim_phase][i1] = decim_x1[decim_phase][i1 + DECIM_T1] = x;
+
+  if ( decim_phase ) {
+      return;
+  }
+
+  // Stage 1, at 2x the sample frequency.
+  int y = (decim_x1[1][decim_i1[1] + DECIM_N1/4] << 13) + (1 << 13);
+  y = dsp_fir_sym(&decim_x1[0][decim_i1[0]], decim_h1, DECIM_T1, y);
+  y = dsp_ssat16(y >> 14);
+
+  decim_p2 ^= 1;
+  int& i2 = decim_i2[decim_p2];
+  i2 = i2 ? i2 - 1 : DECIM_T2 - 1;
+  decim_x2[decim_p2][i2] = decim_x2[decim_p2][i2 + DECIM_T2] = y;
+}
+
+// Stage 2, evaluated when the output is read.
+RESID_INLINE
+int SID16::output_decimated()
+{
+  // Nonzero taps: the newest input and every other one before, center tap:
+  // 19 inputs back, i.e. the 10th newest in the other buffer.
+  const int p = decim_p2, q = p ^ 1;
+  int y = (decim_x2[q][decim_i2[q] + DECIM_N2/4] << 13) + (1 << 13);
+  return dsp_fir_sym(&decim_x2[p][decim_i2[p]], decim_h2, DECIM_T2, y) >> 14;
 }
 
 
@@ -987,6 +1409,65 @@ int SID16::clock(cycle_count& delta_t, short* buf, int n, int interleave)
   }
 }
 
+// ----------------------------------------------------------------------------
+// Block rendering: advances the SID by 'cycles' cycles, applies the writes
+// (sorted by cycle, relative to the start of the block, at most 'cycles') at
+// their time stamps and emits an output sample whenever one is due. The sample
+// clock is the same as the one in handleBus() (integer phase accumulator).
+// The SID is only clocked up to writes and samples, the remaining cycles and
+// the sample phase carry over to the next call, i.e. the output does not
+// depend on how a span is split into blocks.
+// Samples beyond maxSamples are dropped.
+// Returns the number of samples written to out.
+// Not used by the firmware: the sample clock is owned by handleBus(), the
+// emulation core clocks up to each command and sample tick and reads
+// output() per sample (emulateCyclesReSID(), outputReSID()). skpico_bench
+// compares both ways of clocking.
+// ----------------------------------------------------------------------------
+int SID16::render(cycle_count cycles, const WriteEvent* events, int nEvents,
+		  short* out, int maxSamples)
+{
+  int s = 0;
+  cycle_count t = 0;
+  cycle_count t_clocked = -render_pending;
+
+  for (;;) {
+    // cycle at which the next sample is due
+    cycle_count t_sample = t + (render_period - render_phase) / render_step + 1;
+
+    // apply all writes up to the next sample
+    while (nEvents && events->cycle <= t_sample) {
+      if (events->cycle > t_clocked) {
+        clock(events->cycle - t_clocked);
+        t_clocked = events->cycle;
+      }
+      write(events->reg, events->value);
+      events++;
+      nEvents--;
+    }
+
+    if (t_sample > cycles) {
+      break;
+    }
+
+    if (t_sample > t_clocked) {
+      clock(t_sample - t_clocked);
+      t_clocked = t_sample;
+    }
+    render_phase += (t_sample - t) * render_step - render_period;
+    t = t_sample;
+
+    if (s < maxSamples) {
+      out[s++] = output();
+    }
+  }
+
+  render_phase += (cycles - t) * render_step;
+  render_pending = cycles - t_clocked;
+
+  return s;
+}
+
 // ----------------------------------------------------------------------------
 // SID clocking with audio sampling - delta clocking picking nearest sample.
 // ----------------------------------------------------------------------------
@@ -28,6 +28,16 @@
 #include "filter.h"
 #include "extfilt.h"
 #include "pot.h"
+#include "dsp.h"
+
+// Register write for SID16::render() (host tools only), cycle is relative to
+// the start of the block.
+struct WriteEvent
+{
+  cycle_count cycle;
+  reg8 reg;
+  reg8 value;
+};
 
 class SID16
 {
@@ -43,18 +53,30 @@ public:
 			       float filter_scale = 0.97);
   void adjust_sampling_frequency(float sample_freq);
 
+  // ACCURACY_DELTA: clock(delta_t) clocks delta_t cycles at once.
+  // ACCURACY_CYCLE: clock(delta_t) clocks cycle by cycle, including the
+  // pipelines and the combined waveform writeback of single cycle clocking.
+  // ACCURACY_HYBRID: cycle by cycle only while a voice uses combined
+  // waveforms or hard sync.
+  void set_accuracy(accuracy_tier tier);
+
   //void fc_default(const fc_point*& points, int& count);
   //PointPlotter<sound_sample> fc_plotter();
 
   void clock();
   void clock(cycle_count delta_t);
   int clock(cycle_count& delta_t, short* buf, int n, int interleave = 1);
+  int render(cycle_count cycles, const WriteEvent* events, int nEvents,
+	     short* out, int maxSamples);
   void reset();
+  void power_on();
   
   // Read/write registers.
   reg8 read(reg8 offset);
   void write(reg8 offset, reg8 value);
   void readRegisters( unsigned char *p );
+  // OSC3/ENV3 at n points 'step' cycles apart from now on, without register writes.
+  void predictVoice3(unsigned char* osc3, unsigned char* env3, int n, cycle_count step);
 
   Filter filter;
   ExternalFilter extfilt;
@@ -94,6 +116,9 @@ public:
 
   void forceDigiOutput( int voice, int value );
 
+  // Cycles clocked one by one (wraps around), for the cycle budget report.
+  unsigned int cycles_exact;
+
   #ifdef USE_RGB_LED
   int voiceOut[ 3 ];
   #endif
@@ -144,17 +169,98 @@ protected:
   cycle_count sample_offset;
   int sample_index;
   short sample_prev;
+
+  // Sample clock of render(): a sample is due whenever render_phase, 
+  // advanced by render_step per cycle, exceeds render_period.
+  // render_pending: cycles not yet clocked at the end of the last block.
+  int render_phase;
+  cycle_count render_pending;
+  int render_step;
+  int render_period;
   int fir_N;
   int fir_RES;
 
   int v0p;
   int forceOutput[ 3 ];
 
+  accuracy_tier accuracy;
+
   // Ring buffer with overflow for contiguous storage of RINGSIZE samples.
   short* sample;
 
   // FIR_RES filter tables (FIR_N*FIR_RES).
   short* fir;
+
+  // the two steps of clock(delta_t)
+  RESID_INLINE void clock_voices(cycle_count delta_t);
+  RESID_INLINE void clock_waveforms(cycle_count delta_t);
+  RESID_INLINE static void clock_oscillators(Voice* voice, cycle_count delta_t);
+  RESID_INLINE void clock_filters(cycle_count delta_t);
+  RESID_INLINE void filter_inputs(sound_sample* in);
+  RESID_INLINE void clock_extfilt(cycle_count delta_t);
+  // clock_chip() takes the delta_t path (clock_voices(), clock_filters()).
+  RESID_INLINE bool clock_delta_path();
+
+  // clock(delta_t) for ACCURACY_CYCLE/ACCURACY_HYBRID
+  RESID_INLINE bool clock_exact_needed();
+  void clock_exact(cycle_count delta_t);
+  RESID_INLINE void clock_chip(cycle_count delta_t);
+
+  // SAMPLE_DECIMATE: the output is averaged over sub-sample periods of 1/4
+  // sample (176.4kHz for 44.1kHz output) within the step loop of the
+  // external filter, and decimated by two half-band filters: 11 taps to 2x
+  // the sample frequency, and 39 taps evaluated when the output is read.
+  static const int DECIM_N1 = 11;
+  static const int DECIM_N2 = 39;
+  // Nonzero taps besides the center.
+  static const int DECIM_T1 = (DECIM_N1 + 1)/2;
+  static const int DECIM_T2 = (DECIM_N2 + 1)/2;
+  void clock_decimate(cycle_count delta_t);
+  RESID_INLINE void integrate(sound_sample Vo, cycle_count delta_t);
+  void decimate();
+  RESID_INLINE int output_decimated();
+  void reset_decimation();
+
+  // Sub-sample period (16.16), its fractional part accumulated so far,
+  // cycles left and total length of the current sub-sample period.
+  int decim_period;
+  int decim_frac;
+  cycle_count decim_left;
+  cycle_count decim_len;
+  // External filter output plus digi output (at the same scale) integrated
+  // over the current sub-sample period.
+  int decim_sum;
+  // The first stage outputs every second sub-sample.
+  int decim_phase;
+  // Filter inputs split into even and odd samples: the nonzero taps of a
+  // half-band filter are every other input, i.e. contiguous in one of the
+  // two doubled ring buffers (newest sample first), the center tap is in
+  // the other one. decim_p2 is the buffer with the newest stage 2 input.
+  int decim_i1[2], decim_i2[2];
+  int decim_p2;
+  short decim_x1[2][2*DECIM_T1];
+  short decim_x2[2][2*DECIM_T2];
+
+  // Voices (bit i = voice i) whose waveform output has not been calculated
+  // in the last clock_voices() as their envelope output is zero.
+  reg8 wave_deferred;
+  RESID_INLINE void flush_waveform_output(reg8 voices);
+
+friend class ExternalFilter;
+friend class DualSID16;
+};
+
+// Two SIDs clocked together (dual SID configurations): clock(delta_t) gives
+// the same results as sid[0].clock(delta_t) followed by sid[1].clock(delta_t).
+// While both chips take the delta_t path with 6581 filter distortion, the
+// envelopes of the six voices are clocked in one loop and the integrator
+// steps of both filters are interleaved (Filter::clock_dual()).
+class DualSID16
+{
+public:
+  void clock(cycle_count delta_t);
+
+  SID16 sid[2];
 };
 
 #endif // not __SID_H__
@@ -49,7 +49,11 @@ typedef sound_sample fc_point[2];
 enum chip_model { MOS6581, MOS8580 };
 
 enum sampling_method { SAMPLE_FAST, SAMPLE_INTERPOLATE,
-		       SAMPLE_RESAMPLE_INTERPOLATE, SAMPLE_RESAMPLE_FAST };
+		       SAMPLE_RESAMPLE_INTERPOLATE, SAMPLE_RESAMPLE_FAST,
+		       SAMPLE_DECIMATE };
+
+// Emulation accuracy of SID16::clock(delta_t), see SID16::set_accuracy().
+enum accuracy_tier { ACCURACY_DELTA, ACCURACY_CYCLE, ACCURACY_HYBRID };
 
 extern "C"
 {
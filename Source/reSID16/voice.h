@@ -56,6 +56,7 @@ protected:
 int freezedEnvelope;
 
 friend class SID16;
+friend class DualSID16;
 };
 
 
@@ -107,6 +108,10 @@ int Voice::output()
 	if ( wave.floating_output_ttl >= 0x14000 - 64 )
 		freezedEnvelope = envelope.output();
 
+	// Silent voice: no waveform/DAC work, only the DC offset remains.
+	if ( !envelope.output() )
+		return voice_DC;
+
 	// Multiply oscillator output with envelope output.
 	return ( wave.output() - wave_zero ) * envelope.output() + voice_DC;
 }
@@ -34,11 +34,47 @@
 #else
 #endif
 
+reg24 WaveformGenerator::shift_register_jump[7][23];
+
+// ----------------------------------------------------------------------------
+// Build the shift register transition matrices for 2^6 .. 2^12 shifts.
+// The shift register is linear over GF(2); column b of a matrix is the
+// register after the shifts when starting with only bit b set.
+// ----------------------------------------------------------------------------
+void WaveformGenerator::build_shift_register_jump()
+{
+  for (int b = 0; b < 23; b++) {
+    shift_register_jump[0][b] = shift_register_leap(1 << b, 64);
+  }
+
+  // Squaring: 2^(j+1) shifts are 2^j shifts applied twice.
+  for (int j = 1; j < 7; j++) {
+    for (int b = 0; b < 23; b++) {
+      reg24 sr = shift_register_jump[j - 1][b];
+      reg24 r = 0;
+      for (int i = 0; i < 23; i++) {
+        if (sr & (1 << i)) {
+          r ^= shift_register_jump[j - 1][i];
+        }
+      }
+      shift_register_jump[j][b] = r;
+    }
+  }
+}
+
+
 // ----------------------------------------------------------------------------
 // Constructor.
 // ----------------------------------------------------------------------------
 WaveformGenerator::WaveformGenerator()
 {
+  static bool class_init;
+
+  if (!class_init) {
+    build_shift_register_jump();
+    class_init = true;
+  }
+
   sync_source = this;
 
   sid_model = MOS6581;
@@ -83,11 +119,24 @@ void WaveformGenerator::set_chip_model(chip_model model)
 void WaveformGenerator::writeFREQ_LO(reg8 freq_lo)
 {
   freq = (freq & 0xff00) | (freq_lo & 0x00ff);
+  set_msb_period();
 }
 
 void WaveformGenerator::writeFREQ_HI(reg8 freq_hi)
 {
   freq = ((freq_hi << 8) & 0xff00) | (freq & 0x00ff);
+  set_msb_period();
+}
+
+// Half period of the accumulator MSB for hard sync scheduling, see
+// msb_toggle_advance().
+void WaveformGenerator::set_msb_period()
+{
+  if (freq) {
+    msb_period_q = 0x800000/freq;
+    msb_period_m = 0x800000%freq;
+  }
+  msb_next = 0;
 }
 
 void WaveformGenerator::writePW_LO(reg8 pw_lo)
@@ -219,6 +268,9 @@ void WaveformGenerator::reset()
   freq = 0;
   pw = 0;
 
+  set_msb_period();
+  msb_next_acc = 0;
+
   msb_rising = false;
 
   waveform = 0;
@@ -61,11 +61,25 @@ public:
   void set_waveform_output();
   void set_waveform_output(cycle_count delta_t);
 
+  // Whether set_waveform_output() only sets the waveform output, i.e. does
+  // not write back to the accumulator or the shift register.
+  bool waveform_output_is_pure();
+
+  // Cycles until the next accumulator MSB toggle, and advancing this
+  // count after the oscillator has been clocked (hard sync scheduling).
+  cycle_count msb_toggle_cycles();
+  void msb_toggle_advance(cycle_count delta_t);
+
 protected:
   void clock_shift_register();
+  void clock_shift_register(reg24 shifts);
   void write_shift_register();
   void reset_shift_register();
   void set_noise_output();
+  void set_msb_period();
+
+  static reg24 shift_register_leap(reg24 sr, reg24 shifts);
+  static void build_shift_register_jump();
 
   const WaveformGenerator* sync_source;
   WaveformGenerator* sync_dest;
@@ -75,6 +89,14 @@ protected:
   // Tell whether the accumulator MSB was set high on this cycle.
   bool msb_rising;
 
+  // Hard sync scheduling: cycles to the next MSB toggle for the
+  // accumulator value msb_next_acc (0 = not calculated), and
+  // 0x800000 = msb_period_q*freq + msb_period_m.
+  cycle_count msb_next;
+  reg24 msb_next_acc;
+  reg24 msb_period_q;
+  reg24 msb_period_m;
+
   // Fout  = (Fn*Fclk/16777216)Hz
   // reg16 freq;
   reg24 freq;
@@ -83,6 +105,10 @@ protected:
 
   reg24 shift_register;
 
+  // GF(2) transition matrices of the shift register for 2^6 .. 2^12 shifts,
+  // stored as the images of the 23 single bit states.
+  static reg24 shift_register_jump[7][23];
+
   // Remaining time to fully reset shift register.
   cycle_count shift_register_reset;
   // Emulation of pipeline causing bit 19 to clock the shift register.
@@ -196,6 +222,7 @@ void WaveformGenerator::clock(cycle_count delta_t)
   else {
     // Calculate new accumulator value;
     reg24 delta_accumulator = delta_t*freq;
+    reg24 accumulator_prev = accumulator;
     reg24 accumulator_next = (accumulator + delta_accumulator) & 0xffffff;
     reg24 accumulator_bits_set  = ~accumulator & accumulator_next;
     accumulator = accumulator_next;
@@ -206,36 +233,17 @@ void WaveformGenerator::clock(cycle_count delta_t)
     // NB! Any pipelined shift register clocking from single cycle clocking
     // will be lost. It is not worth the trouble to flush the pipeline here.
 
-    // Shift noise register once for each time accumulator bit 19 is set high.
-    // Bit 19 is set high each time 2^20 (0x100000) is added to the accumulator.
-    reg24 shift_period = 0x100000;
-
-    while (delta_accumulator) {
-      if ((delta_accumulator < shift_period)) {
-        shift_period = delta_accumulator;
-        // Determine whether bit 19 is set on the last period.
-        // NB! Requires two's complement integer.
-        if ((shift_period <= 0x080000)) {
-          // Check for flip from 0 to 1.
-          if (((accumulator - shift_period) & 0x080000) || !(accumulator & 0x080000))
-            {
-              break;
-            }
-        }
-        else {
-          // Check for flip from 0 (to 1 or via 1 to 0) or from 1 via 0 to 1.
-          if (((accumulator - shift_period) & 0x080000) && !(accumulator & 0x080000))
-            {
-              break;
-            }
-        }
-      }
+    // Shift noise register once for each time accumulator bit 19 is set high,
+    // i.e. each time the accumulator passes 0x080000 modulo 2^20 (0x100000).
+    // The 24 bit wraparound is a multiple of 2^20 and does not matter.
+    reg24 shifts =
+      reg24(((unsigned long long)accumulator_prev + 0x080000 + delta_accumulator) >> 20) -
+      ((accumulator_prev + 0x080000) >> 20);
 
+    if ((shifts)) {
       // Shift the noise/random register.
       // NB! The two-cycle pipeline delay is only modeled for 1 cycle clocking.
-      clock_shift_register();
-
-      delta_accumulator -= shift_period;
+      clock_shift_register(shifts);
     }
 
     // Calculate pulse high/low.
@@ -331,6 +339,53 @@ void WaveformGenerator::clock_shift_register()
   set_noise_output();
 }
 
+// Shift the register a number of times without intermediate noise output.
+// Up to 18 shifts are done at once: the feedback bits bit22 ^ bit17 of the
+// next 18 shifts only depend on register bits which are not yet shifted out.
+//RESID_INLINE 
+__attribute__((always_inline)) inline
+reg24 WaveformGenerator::shift_register_leap(reg24 sr, reg24 shifts)
+{
+  while (shifts) {
+    reg24 n = shifts < 18 ? shifts : 18;
+    reg24 bits = ((sr >> (23 - n)) ^ (sr >> (18 - n))) & ((1 << n) - 1);
+    sr = ((sr << n) | bits) & 0x7fffff;
+    shifts -= n;
+  }
+  return sr;
+}
+
+// Clock the shift register a number of times (clock(delta_t) only, there is
+// no combined waveform writeback in between).
+// Multiples of 64 shifts use the GF(2) transition matrices, the rest is
+// done by shift_register_leap().
+//RESID_INLINE 
+__attribute__((always_inline)) inline
+void WaveformGenerator::clock_shift_register(reg24 shifts)
+{
+  reg24 sr = shift_register;
+
+  if ((shifts >= 64)) {
+    for (int j = 0; j < 7; j++) {
+      if (shifts & (64 << j)) {
+        const reg24* m = shift_register_jump[j];
+        reg24 r = 0;
+        for (reg24 bits = sr; bits; bits &= bits - 1) {
+          r ^= m[__builtin_ctz(bits)];
+        }
+        sr = r;
+      }
+    }
+    // NB! No more than 2^13 - 1 shifts are possible for delta_t*freq < 2^32.
+    shifts &= 63;
+  }
+
+  shift_register = shift_register_leap(sr, shifts);
+
+  // New noise waveform output.
+  set_noise_output();
+}
+
 //RESID_INLINE 
 __attribute__((always_inline)) inline
 void WaveformGenerator::write_shift_register()
@@ -606,6 +661,63 @@ void WaveformGenerator::set_waveform_output(cycle_count delta_t)
 }
 
 
+// ----------------------------------------------------------------------------
+// Hard sync scheduling.
+// The number of cycles to the next MSB toggle is a function of accumulator
+// and freq only. It is calculated by division when the accumulator has been
+// changed by other means than clocking (register writes, sync, combined
+// waveforms), and otherwise counted down while the oscillator is clocked.
+// ----------------------------------------------------------------------------
+__attribute__((always_inline)) inline
+cycle_count WaveformGenerator::msb_toggle_cycles()
+{
+  if ((msb_next_acc != accumulator) || !msb_next) {
+    if (!accumulator) {
+      // Reset by hard sync or the test bit.
+      msb_next = msb_period_q + (msb_period_m ? 1 : 0);
+    }
+    else {
+      // Clock on MSB off if MSB is on, clock on MSB on if MSB is off.
+      reg24 delta_accumulator =
+        (accumulator & 0x800000 ? 0x1000000 : 0x800000) - accumulator;
+
+      msb_next = delta_accumulator/freq;
+      if ((delta_accumulator%freq)) {
+        ++msb_next;
+      }
+    }
+    msb_next_acc = accumulator;
+  }
+  return msb_next;
+}
+
+__attribute__((always_inline)) inline
+void WaveformGenerator::msb_toggle_advance(cycle_count delta_t)
+{
+  // The test bit holds the accumulator.
+  if ((test)) {
+    return;
+  }
+
+  msb_next -= delta_t;
+  if (!msb_next) {
+    // The MSB has toggled on the last cycle, the accumulator is now r < freq
+    // past the toggle: ceil((0x800000 - r)/freq) = q + (m > r).
+    reg24 r = accumulator & 0x7fffff;
+    msb_next = msb_period_q + (msb_period_m > r ? 1 : 0);
+  }
+  msb_next_acc = accumulator;
+}
+
+__attribute__((always_inline)) inline
+bool WaveformGenerator::waveform_output_is_pure()
+{
+  return waveform
+    && !((waveform > 0x8) && !test)
+    && !((waveform & 0x2) && (waveform & 0xd) && (sid_model == MOS6581));
+}
+
+
 // ----------------------------------------------------------------------------
 // Waveform output (12 bits).
 // ----------------------------------------------------------------------------
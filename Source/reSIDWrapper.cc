@@ -42,10 +42,14 @@
 #define SET_CLOCK_125MHZ set_sys_clock_pll( 1500000000, 6, 2 );
 #define SET_CLOCK_FAST   set_sys_clock_pll( 1500000000, 5, 1 );
 
+#ifdef SKPICO_HOST
+#define DELAY_Nx3p2_CYCLES( c )
+#else
 #define DELAY_Nx3p2_CYCLES( c )								\
     asm volatile( "mov  r0, %[_c]\n\t"							\
 				  "1: sub  r0, r0, #1\n\t"					\
 				  "bne   1b"  : : [_c] "r" (c) : "r0", "cc", "memory" );
+#endif
 
 static int32_t cfgVolSID1_Left, cfgVolSID1_Right;
 static int32_t cfgVolSID2_Left, cfgVolSID2_Right;
@@ -58,6 +62,7 @@ static int32_t actVolFM_Left, actVolFM_Right;
 #endif
 
 uint32_t C64_CLOCK = 985248;
+uint32_t AUDIO_RATE = 44100;
 uint8_t  SID_DIGI_DETECT = 0;
 uint32_t SID2_FLAG = 0; 
 uint8_t  SID2_IOx_global = 0;
@@ -73,6 +78,7 @@ uint8_t  configCurrent[ 64 ];
 int32_t  voiceOutAcc[ 3 ], nSamplesAcc;
 #endif
 
+DualSID16 *dualSID;
 SID16 *sid16;
 SID16 *sid16b;
 
@@ -133,6 +139,18 @@ extern "C"
         #endif
     }
 
+    // a configuration loaded from flash: settings which are not in the configuration tool may hold anything
+    // (bytes unused by earlier firmware versions), out-of-range values are reset to the default
+    void validateConfiguration()
+    {
+        if ( config[ CFG_EMULATION_ACCURACY ] > 2 )
+            config[ CFG_EMULATION_ACCURACY ] = 0;
+        if ( config[ CFG_SAMPLE_DECIMATE ] > 1 )
+            config[ CFG_SAMPLE_DECIMATE ] = 0;
+        if ( config[ CFG_AUDIO_RATE ] > 2 )
+            config[ CFG_AUDIO_RATE ] = 0;
+    }
+
     void updateConfiguration()
     {
 
@@ -161,8 +179,28 @@ extern "C"
             sid16b->input( 0 );
 
         C64_CLOCK = c64clock[ config[ CFG_CLOCKSPEED ] % 3 ];
-        sid16->set_sampling_parameters( C64_CLOCK, SAMPLE_INTERPOLATE, 44100 );
-        sid16b->set_sampling_parameters( C64_CLOCK, SAMPLE_INTERPOLATE, 44100 );
+
+        // the emulation core picks up a new rate for the FM engine and I2S output with the next sample
+        const uint32_t audioRate[ 3 ] = { 44100, 48000, 96000 };
+        AUDIO_RATE = audioRate[ config[ CFG_AUDIO_RATE ] % 3 ];
+        #if !defined( SKPICO_2350 ) && !defined( SKPICO_2350CR ) && !defined( SKPICO_HOST )
+        if ( AUDIO_RATE > 48000 )
+            AUDIO_RATE = 48000;
+        #endif
+
+        sampling_method sampling = config[ CFG_SAMPLE_DECIMATE ] ? SAMPLE_DECIMATE : SAMPLE_INTERPOLATE;
+        sid16->set_sampling_parameters( C64_CLOCK, sampling, AUDIO_RATE );
+        sid16b->set_sampling_parameters( C64_CLOCK, sampling, AUDIO_RATE );
+
+        // single-cycle clocking costs 8-17x the default (skpico_bench), the RP2040 is limited to hybrid
+        accuracy_tier accuracy = (accuracy_tier)( config[ CFG_EMULATION_ACCURACY ] % 3 );
+        #if !defined( SKPICO_2350 ) && !defined( SKPICO_2350CR ) && !defined( SKPICO_HOST )
+        if ( accuracy == ACCURACY_CYCLE )
+            accuracy = ACCURACY_HYBRID;
+        #endif
+
+        sid16->set_accuracy( accuracy );
+        sid16b->set_accuracy( accuracy );
 
         extern const uint32_t sidFlags[ 6 ];
         SID2_FLAG = sidFlags[ config[ CFG_SID2_ADDRESS ] % 6 ];
@@ -293,15 +331,17 @@ extern "C"
     	extern char *exo_decrunch( const char *in, char *out );
 	    exo_decrunch( (const char*)&reSID_LUTs_exo[ reSID_LUTs_exo_size ], (char*)&reSID_LUTs[32768] );
 
-        sid16 = new SID16();
+        dualSID = new DualSID16();
+
+        sid16 = &dualSID->sid[ 0 ];
         sid16->set_chip_model( MOS8580 );
         sid16->reset();
-        sid16->set_sampling_parameters( C64_CLOCK, SAMPLE_INTERPOLATE, 44100 );
+        sid16->set_sampling_parameters( C64_CLOCK, SAMPLE_INTERPOLATE, AUDIO_RATE );
 
-        sid16b = new SID16();
+        sid16b = &dualSID->sid[ 1 ];
         sid16b->set_chip_model( MOS8580 );
         sid16b->reset();
-        sid16b->set_sampling_parameters( C64_CLOCK, SAMPLE_INTERPOLATE, 44100 );
+        sid16b->set_sampling_parameters( C64_CLOCK, SAMPLE_INTERPOLATE, AUDIO_RATE );
 
         // enforce full update of the configuration
         for ( int i = 0; i < 64; i ++)
@@ -319,8 +359,7 @@ extern "C"
 
     void emulateCyclesReSID( int cyclesToEmulate )
     {
-        sid16->clock( cyclesToEmulate );
-        sid16b->clock( cyclesToEmulate );
+        dualSID->clock( cyclesToEmulate );
     }
 
     void emulateCyclesReSIDSingle( int cyclesToEmulate )
@@ -352,13 +391,8 @@ extern "C"
        int32_t L = sid1 * actVolSID1_Left + (fm * actVolFM_Left*2);
         int32_t R = sid1 * actVolSID1_Right + (fm * actVolFM_Right*2);
 
-        L >>= 16; R >>= 16;
-        if ( L > 32767 ) L = 32767;
-        if ( R > 32767 ) R = 32767;
-        if ( L < -32767 ) L = -32767;
-        if ( R < -32767 ) R = -32767;
-        *left = L;
-        *right = R;
+        *left = dsp_mix_sat( L );
+        *right = dsp_mix_sat( R );
 
 
     #ifdef USE_RGB_LED
@@ -409,8 +443,8 @@ extern "C"
         int32_t L = sid1 * actVolSID1_Left + sid2 * actVolSID2_Left;
         int32_t R = sid1 * actVolSID1_Right + sid2 * actVolSID2_Right;
 
-        *left = L >> 16;
-        *right = R >> 16;
+        *left = dsp_mix_sat( L );
+        *right = dsp_mix_sat( R );
 
         #ifdef USE_RGB_LED
         // SID #1 voices map to red, green, blue
@@ -435,13 +469,8 @@ extern "C"
         int32_t L = sid1 * actVolSID1_Left + (fm * actVolSID2_Left*2);
         int32_t R = sid1 * actVolSID1_Right + (fm * actVolSID2_Right*2);
 
-        L >>= 16; R >>= 16;
-        if ( L > 32767 ) L = 32767;
-        if ( R > 32767 ) R = 32767;
-        if ( L < -32767 ) L = -32767;
-        if ( R < -32767 ) R = -32767;
-        *left = L;
-        *right = R;
+        *left = dsp_mix_sat( L );
+        *right = dsp_mix_sat( R );
 
 
     #ifdef USE_RGB_LED
@@ -487,10 +516,11 @@ extern "C"
     }
 
 
+    // power-on state of both SIDs (the host tools start each run from it)
     void resetReSID()
     {
-        sid16->reset();
-        sid16b->reset();
+        sid16->power_on();
+        sid16b->power_on();
     }
 
     void readRegs( uint8_t * p1, uint8_t * p2 )
@@ -499,6 +529,12 @@ extern "C"
         sid16b->readRegisters( p2 );
     }
 
+    // OSC3/ENV3 ahead of the emulation, for the bus core (voice3Ahead.h)
+    void predictVoice3( uint8_t sid, uint8_t * osc3, uint8_t * env3, int n, int step )
+    {
+        ( sid ? sid16b : sid16 )->predictVoice3( osc3, env3, n, step );
+    }
+
     uint8_t readSID( uint8_t offset )
     {
         return sid16->read( offset );
@@ -38,6 +38,13 @@
 
 // 0 .. 14
 #define CFG_SID_PANNING         12
+
+// reSID clocking: 0 = delta_t (default), 1 = single cycles, 2 = single cycles for combined waveforms/sync only
+#define CFG_EMULATION_ACCURACY  13
+// output: 0 = sampled at the sample clock (default), 1 = band-limited (4x sub-sampled and decimated, see SAMPLE_DECIMATE)
+#define CFG_SAMPLE_DECIMATE     14
+// output rate: 0 = 44.1kHz (default), 1 = 48kHz, 2 = 96kHz (RP2350 only, 48kHz otherwise)
+#define CFG_AUDIO_RATE          15
 #define CFG_SID_BALANCE         58
 
 #define CFG_REGISTER_READ       2
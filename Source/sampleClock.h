@@ -0,0 +1,81 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  sampleClock.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// the bus side's sample tick: a new sample is due every C64_CLOCK / AUDIO_RATE cycles. Instead of
+// accumulating AUDIO_RATE every cycle, the cycle of the next tick is computed when a tick happens
+// (integer step plus the fractional remainder, Bresenham-style), so the per-cycle work is a single
+// comparison against c64CycleCounter. The ticks fall on the same cycles as with the accumulator
+// (curSample += AUDIO_RATE; tick when curSample > C64_CLOCK).
+//
+// changes of AUDIO_RATE or C64_CLOCK are picked up with the next tick; when the clock fell behind
+// (c64CycleCounter running without ticks in transfer mode) it restarts from now. Setting
+// c64CycleCounter back requires calling sampleClockStart()
+//
+
+#ifndef _SAMPLECLOCK_H_
+#define _SAMPLECLOCK_H_
+
+typedef struct
+{
+	uint32_t step, rem, frac;				// C64_CLOCK / AUDIO_RATE, C64_CLOCK % AUDIO_RATE, accumulated remainder
+	uint32_t rate, clock;					// AUDIO_RATE and C64_CLOCK the step is computed for
+} SAMPLE_CLOCK;
+
+#define SAMPLE_DUE( now, next )		( (int32_t)( (now) - (next) ) >= 0 )
+
+// returns the cycle of the first tick, as if the accumulator started at 0 at cycle 'now'
+static inline uint32_t sampleClockStart( SAMPLE_CLOCK *s, uint32_t now )
+{
+	s->rate  = AUDIO_RATE;
+	s->clock = C64_CLOCK;
+	s->step  = s->clock / s->rate;
+	s->rem   = s->clock % s->rate;
+	s->frac  = s->rem;
+	return now + s->step + 1;
+}
+
+// called at the tick due at cycle 'next', returns the cycle of the following one
+static inline uint32_t sampleClockAdvance( SAMPLE_CLOCK *s, uint32_t next, uint32_t now )
+{
+	if ( s->rate != AUDIO_RATE || s->clock != C64_CLOCK )
+		return sampleClockStart( s, now );
+
+	next += s->step;
+	s->frac += s->rem;
+	if ( s->frac >= s->rate )
+	{
+		s->frac -= s->rate;
+		next ++;
+	}
+
+	if ( SAMPLE_DUE( now, next ) )
+		return sampleClockStart( s, now );
+
+	return next;
+}
+
+#endif
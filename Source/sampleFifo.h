@@ -0,0 +1,155 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  sampleFifo.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// output samples between the emulation core (producer) and handleBus() (consumer). At each sample tick
+// (sampleClock.h) handleBus() counts a request and records the cycle of the tick. The emulation core renders
+// one sample per request -- all of them, also when it fell behind by several ticks -- each one after
+// emulating exactly up to the cycle of its tick, and appends it to the FIFO. handleBus() takes one sample per
+// tick from the FIFO for the PWM output, i.e. the output lags behind by SAMPLE_FIFO_LATENCY samples, in
+// exchange a late emulation core no longer loses samples or renders them at the wrong time. If the FIFO runs
+// empty (an underrun), the output keeps its level until the FIFO holds SAMPLE_FIFO_LATENCY samples again,
+// such that the latency stays the same. Builds without PWM output (I2S DAC) only use the requests, their
+// output is paced by the audio buffers.
+//
+// counters (since boot): sampleFifoLate (samples rendered after the following tick), sampleFifoUnderruns
+// (ticks without a sample to output) and sampleFifoOverflows (samples dropped as the FIFO was full, or
+// requests dropped as the emulation core fell behind by more than SAMPLE_FIFO_SIZE - 1 ticks)
+//
+// as for the ring buffer (busRing.h) each index is written by one side only. Included by emulationCore.h,
+// the includer has to provide busRing.h (RING_LOAD_ACQUIRE/RING_STORE_RELEASE)
+//
+
+#ifndef _SAMPLEFIFO_H_
+#define _SAMPLEFIFO_H_
+
+#define SAMPLE_FIFO_SIZE		16
+#define SAMPLE_FIFO_MASK		( SAMPLE_FIFO_SIZE - 1 )
+#define SAMPLE_FIFO_LATENCY		4				// in samples, about 90us at 44.1kHz
+
+typedef struct
+{
+	uint16_t value[ 2 ];						// device: PWM level of audio and LED; host: left and right
+} SAMPLE_FIFO_ENTRY;
+
+SAMPLE_FIFO_ENTRY sampleFifo[ SAMPLE_FIFO_SIZE ];
+volatile uint32_t sampleFifoWrite = 0;			// written by the emulation core only
+volatile uint32_t sampleFifoRead = 0;			// written by handleBus() only
+
+uint32_t sampleTickCycle[ SAMPLE_FIFO_SIZE ];	// handleBus(): c64CycleCounter of request i at [ i & SAMPLE_FIFO_MASK ]
+volatile uint32_t sampleRequests = 0;			// handleBus(): sample ticks so far
+uint32_t sampleRendered = 0;					// emulation core: requests served so far
+uint8_t  sampleFifoPriming = 1;					// handleBus(): waiting for SAMPLE_FIFO_LATENCY samples
+
+volatile uint32_t sampleFifoLate = 0;
+volatile uint32_t sampleFifoUnderruns = 0;
+volatile uint32_t sampleFifoOverflows = 0;
+
+// handleBus(), at a sample tick at cycle 'now' without PWM output
+__attribute__((always_inline)) static inline void sampleFifoRequest( uint32_t now )
+{
+	uint32_t r = sampleRequests;
+	sampleTickCycle[ r & SAMPLE_FIFO_MASK ] = now;
+	RING_STORE_RELEASE( sampleRequests, r + 1 );
+}
+
+// handleBus(), at a sample tick at cycle 'now' with PWM output: returns 1 and the sample to output, 0 while priming
+__attribute__((always_inline)) static inline uint32_t sampleFifoTick( uint32_t now, uint16_t *value )
+{
+	sampleFifoRequest( now );
+
+	uint32_t rd = sampleFifoRead;
+	uint32_t fill = RING_LOAD_ACQUIRE( sampleFifoWrite ) - rd;
+
+	if ( sampleFifoPriming )
+	{
+		if ( fill < SAMPLE_FIFO_LATENCY )
+			return 0;
+		sampleFifoPriming = 0;
+	}
+
+	if ( fill == 0 )
+	{
+		sampleFifoUnderruns ++;
+		sampleFifoPriming = 1;
+		return 0;
+	}
+
+	const SAMPLE_FIFO_ENTRY *e = &sampleFifo[ rd & SAMPLE_FIFO_MASK ];
+	value[ 0 ] = e->value[ 0 ];
+	value[ 1 ] = e->value[ 1 ];
+	RING_STORE_RELEASE( sampleFifoRead, rd + 1 );
+	return 1;
+}
+
+// emulation core: returns 1 if a sample is to be rendered, and the cycle of its tick, which the emulation
+// has to reach before rendering it (the request is taken with sampleFifoTake())
+__attribute__((always_inline)) static inline uint32_t sampleFifoDue( uint32_t *cycle )
+{
+	uint32_t requests = RING_LOAD_ACQUIRE( sampleRequests );
+	uint32_t due = requests - sampleRendered;
+
+	if ( due == 0 )
+		return 0;
+
+	// the tick cycles of older requests are (being) overwritten: these samples are lost
+	if ( due > SAMPLE_FIFO_SIZE - 1 )
+	{
+		sampleFifoOverflows += due - ( SAMPLE_FIFO_SIZE - 1 );
+		sampleRendered = requests - ( SAMPLE_FIFO_SIZE - 1 );
+	}
+
+	*cycle = sampleTickCycle[ sampleRendered & SAMPLE_FIFO_MASK ];
+	return 1;
+}
+
+// emulation core: takes the request returned by sampleFifoDue(), counts late samples
+__attribute__((always_inline)) static inline void sampleFifoTake()
+{
+	if ( sampleRequests - sampleRendered > 1 )
+		sampleFifoLate ++;
+
+	sampleRendered ++;
+}
+
+// emulation core: appends a rendered sample
+__attribute__((always_inline)) static inline void sampleFifoPush( uint16_t v0, uint16_t v1 )
+{
+	uint32_t wr = sampleFifoWrite;
+
+	if ( wr - RING_LOAD_ACQUIRE( sampleFifoRead ) >= SAMPLE_FIFO_SIZE )
+	{
+		sampleFifoOverflows ++;
+		return;
+	}
+
+	SAMPLE_FIFO_ENTRY *e = &sampleFifo[ wr & SAMPLE_FIFO_MASK ];
+	e->value[ 0 ] = v0;
+	e->value[ 1 ] = v1;
+	RING_STORE_RELEASE( sampleFifoWrite, wr + 1 );
+}
+
+#endif
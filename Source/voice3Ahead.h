@@ -0,0 +1,112 @@
+/*
+       ______/  _____/  _____/     /   _/    /             /
+     _/           /     /     /   /  _/     /   ______/   /  _/             ____/     /   ______/   ____/
+      ___/       /     /     /   ___/      /   /         __/                    _/   /   /         /     /
+         _/    _/    _/    _/   /  _/     /  _/         /  _/             _____/    /  _/        _/    _/
+  ______/   _____/  ______/   _/    _/  _/    _____/  _/    _/          _/        _/    _____/    ____/
+
+  voice3Ahead.h
+
+  SIDKick pico - SID-replacement with dual-SID/SID+fm emulation using a RPi pico, reSID 0.16 and fmopl
+  Copyright (c) 2023-2025 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// OSC3/ENV3 ($d41b/$d41c) for the bus core. outRegisters[ 0x1b/0x1c ] hold the values at the cycle the
+// emulation core has reached, which lags behind the bus by up to one pass of the emulation loop. While the
+// C64 reads these registers, the emulation core also computes how they continue for the next
+// VOICE3_AHEAD_STEPS << VOICE3_AHEAD_SHIFT cycles (reSID's predictVoice3() on copies of the voices), and the
+// bus core returns the entry for the current cycle, i.e. the value is at most 2^VOICE3_AHEAD_SHIFT - 1
+// cycles old.
+//
+// the lookahead assumes that no register is written: it is only used up to the time stamp of the last
+// command pushed to the ring (ringLastTime) after its start. Beyond its end, or when it is older, the bus
+// core falls back to outRegisters, as it does for the entries the emulation has caught up with (before
+// 'first', which the emulation core advances after updating outRegisters).
+//
+// the bus core looks up the entry before it drives the data lines, and flags the read afterwards
+// (voice3AheadPolled()), such that the volatile store is not on the path to SET_DATA.
+//
+// included by emulationCore.h, which computes the lookahead (emulationVoice3Ahead())
+//
+
+#ifndef _VOICE3AHEAD_H_
+#define _VOICE3AHEAD_H_
+
+#define VOICE3_AHEAD_SHIFT		3			// one entry every 8 cycles ...
+#define VOICE3_AHEAD_STEPS		32			// ... for 256 cycles
+
+typedef struct
+{
+	uint32_t cycle;							// emulation cycle of the first entry
+	volatile uint8_t first;					// entries before this one are behind the emulation
+	uint8_t  osc3[ VOICE3_AHEAD_STEPS ];
+	uint8_t  env3[ VOICE3_AHEAD_STEPS ];
+} VOICE3_AHEAD;
+
+// per SID: two buffers, the emulation core fills the one not published
+VOICE3_AHEAD voice3Ahead[ 2 ][ 2 ];
+volatile uint8_t voice3AheadBuf[ 2 ] = { 0, 0 };
+
+// set by the bus core on reads of $d41b/$d41c; the emulation core keeps the lookahead up to date for
+// VOICE3_POLL_HOLD cycles after it saw the flag, refreshed every VOICE3_AHEAD_REFRESH cycles and after commands
+volatile uint8_t voice3Polled[ 2 ] = { 0, 0 };
+
+#define VOICE3_POLL_HOLD		40000		// about two frames
+#define VOICE3_AHEAD_REFRESH	( ( VOICE3_AHEAD_STEPS << VOICE3_AHEAD_SHIFT ) / 2 )
+
+// the published lookahead of a SID
+__attribute__((always_inline)) static inline const VOICE3_AHEAD *voice3AheadCurrent( uint32_t sid )
+{
+	return &voice3Ahead[ sid ][ RING_LOAD_ACQUIRE( voice3AheadBuf[ sid ] ) ];
+}
+
+// bus core: index of the entry for cycle 'now', or -1 if the lookahead does not cover it or the emulation
+// (i.e. outRegisters) is already past that entry: one unsigned compare against [ first, VOICE3_AHEAD_STEPS )
+__attribute__((always_inline)) static inline int32_t voice3AheadIndex( const VOICE3_AHEAD *v, uint32_t now, uint32_t lastWrite )
+{
+	uint32_t age = now - v->cycle;
+
+	if ( lastWrite - v->cycle < age )
+		age = lastWrite - v->cycle;
+
+	uint32_t first = v->first;
+	uint32_t k = ( age >> VOICE3_AHEAD_SHIFT ) - first;
+
+	if ( k >= VOICE3_AHEAD_STEPS - first )
+		return -1;
+
+	return k + first;
+}
+
+// bus core: read of $d41b/$d41c, 'reg' as in handleBus() (outRegisters of SID #1 or #2)
+__attribute__((always_inline)) static inline uint8_t voice3AheadRead( const uint8_t *reg, uint32_t A, uint32_t now )
+{
+	const VOICE3_AHEAD *v = voice3AheadCurrent( reg != outRegisters );
+	int32_t k = voice3AheadIndex( v, now, ringLastTime );
+	if ( k < 0 )
+		return reg[ A ];
+
+	return A == 0x1b ? v->osc3[ k ] : v->env3[ k ];
+}
+
+// bus core: after the data of such a read is on the bus, keeps the emulation core computing the lookahead
+__attribute__((always_inline)) static inline void voice3AheadPolled( const uint8_t *reg )
+{
+	voice3Polled[ reg != outRegisters ] = 1;
+}
+
+#endif